@@ -0,0 +1,291 @@
+/* bench_argb.c
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Micro-benchmark for the pixel kernels in src/argb.c: every variant (the
+ * old per-pixel loops, C, SSE2, AVX2) runs over a full frame and is checked
+ * against the old loop. Build and run with "make bench-argb".
+ *
+ * Usage: bench_argb [width] [height] [iterations]
+ */
+
+#include "../src/argb.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/******************************************************************************/
+
+static unsigned width = 1920;
+static unsigned height = 1080;
+static unsigned iterations = 100;
+
+static uint32_t *src;
+static uint32_t *dst;
+static uint32_t *ref;
+static uint8_t *bits;
+static uint8_t *ref_bits;
+
+/******************************************************************************/
+
+static uint64_t
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+report(const char *name, uint64_t nsec, bool ok)
+{
+	double pixels = (double) width * height * iterations;
+
+	printf("%-24s %10.3f ms/frame %10.1f Mpixel/s  %s\n", name,
+			(double) nsec / iterations / 1000000.0,
+			pixels / ((double) nsec / 1000.0),
+			ok ? "ok" : "MISMATCH");
+}
+
+/******************************************************************************/
+
+/* the old loop of xsg_xrender_render */
+static void
+mask_bits_old(uint8_t *mask, const uint32_t *d, unsigned w, unsigned h,
+		unsigned xshape)
+{
+	unsigned bpl = (w + 7) / 8;
+	unsigned x, y;
+
+	memset(mask, 0, bpl * h);
+
+	for (y = 0; y < h; y++) {
+		uint8_t *m = mask + y * bpl;
+
+		for (x = 0; x < w; x++) {
+			if ((*d >> 24) >= xshape) {
+				if (xsg_argb_am_big_endian()) {
+					*m |= (1 << (0x7 - (x & 0x7)));
+				} else {
+					*m |= (1 << (x & 0x7));
+				}
+			}
+			if ((x & 0x7) == 0x7) {
+				m++;
+			}
+			d++;
+		}
+	}
+}
+
+typedef unsigned (*mask_bits_func_t)(uint8_t *, const uint32_t *, unsigned,
+		unsigned);
+
+static unsigned
+mask_bits_none(uint8_t *mask, const uint32_t *s, unsigned n, unsigned t)
+{
+	return 0;
+}
+
+static void
+bench_mask_bits(const char *name, mask_bits_func_t func)
+{
+	unsigned bpl = (width + 7) / 8;
+	unsigned i, y;
+	uint64_t start;
+
+	memset(bits, 0, bpl * height);
+
+	start = now();
+
+	for (i = 0; i < iterations; i++) {
+		for (y = 0; y < height; y++) {
+			uint8_t *m = bits + y * bpl;
+			const uint32_t *s = src + y * width;
+			unsigned x = func(m, s, width, 0x80);
+
+			mask_bits_c(m + x / 8, s + x, width - x, 0x80, FALSE);
+		}
+	}
+
+	report(name, now() - start, !memcmp(bits, ref_bits, bpl * height));
+}
+
+/******************************************************************************/
+
+/* the old loop of xsg_imlib_blend_mask */
+static void
+mul_old(uint32_t *d, const uint32_t *m, unsigned n)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++) {
+		unsigned char *img = (unsigned char *) (d + i);
+		const unsigned char *msk = (const unsigned char *) (m + i);
+
+		img[0] = (img[0] * msk[0]) / 0xff;
+		img[1] = (img[1] * msk[1]) / 0xff;
+		img[2] = (img[2] * msk[2]) / 0xff;
+		img[3] = (img[3] * msk[3]) / 0xff;
+	}
+}
+
+typedef unsigned (*mul_func_t)(uint32_t *, const uint32_t *, unsigned);
+
+static unsigned
+mul_none(uint32_t *d, const uint32_t *m, unsigned n)
+{
+	return 0;
+}
+
+static void
+bench_mul(const char *name, mul_func_t func)
+{
+	unsigned n = width * height;
+	uint64_t sum = 0;
+	unsigned i;
+	bool ok;
+
+	for (i = 0; i < iterations; i++) {
+		uint64_t start;
+		unsigned x;
+
+		memcpy(dst, ref, n * sizeof(uint32_t));
+
+		start = now();
+		x = func(dst, src, n);
+		mul_c(dst + x, src + x, n - x);
+		sum += now() - start;
+	}
+
+	ok = TRUE;
+
+	for (i = 0; i < n && ok; i++) {
+		uint32_t expect = ref[i];
+
+		mul_old(&expect, src + i, 1);
+		ok = dst[i] == expect;
+	}
+
+	report(name, sum, ok);
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	unsigned n, bpl, i;
+	uint64_t start, sum;
+
+	if (argc > 1) {
+		width = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		height = atoi(argv[2]);
+	}
+	if (argc > 3) {
+		iterations = atoi(argv[3]);
+	}
+
+	n = width * height;
+	bpl = (width + 7) / 8;
+
+	src = malloc(n * sizeof(uint32_t));
+	dst = malloc(n * sizeof(uint32_t));
+	ref = malloc(n * sizeof(uint32_t));
+	bits = malloc(bpl * height);
+	ref_bits = malloc(bpl * height);
+
+	srand(1);
+
+	for (i = 0; i < n; i++) {
+		src[i] = (uint32_t) rand() << 16 ^ (uint32_t) rand();
+		ref[i] = (uint32_t) rand() << 16 ^ (uint32_t) rand();
+	}
+
+	printf("%ux%u pixels, %u iterations\n\n", width, height, iterations);
+
+	/* alpha threshold to bitmask */
+
+	start = now();
+	for (i = 0; i < iterations; i++) {
+		mask_bits_old(ref_bits, src, width, height, 0x80);
+	}
+	report("mask_bits old", now() - start, TRUE);
+
+	bench_mask_bits("mask_bits c", mask_bits_none);
+#ifdef __SSE2__
+	bench_mask_bits("mask_bits sse2", mask_bits_sse2);
+#endif
+#ifdef HAVE_AVX2
+	if (have_avx2()) {
+		bench_mask_bits("mask_bits avx2", mask_bits_avx2);
+	}
+#endif
+
+	printf("\n");
+
+	/* multiply with mask */
+
+	for (sum = 0, i = 0; i < iterations; i++) {
+		memcpy(dst, ref, n * sizeof(uint32_t));
+		start = now();
+		mul_old(dst, src, n);
+		sum += now() - start;
+	}
+	report("mul old", sum, TRUE);
+
+	bench_mul("mul c", mul_none);
+#ifdef __SSE2__
+	bench_mul("mul sse2", mul_sse2);
+#endif
+#ifdef HAVE_AVX2
+	if (have_avx2()) {
+		bench_mul("mul avx2", mul_avx2);
+	}
+#endif
+
+	printf("\n");
+
+	/* premultiply */
+
+	start = now();
+	for (i = 0; i < iterations; i++) {
+		premultiply_c(dst, src, n);
+	}
+	report("premultiply c", now() - start, TRUE);
+
+#ifdef __SSE2__
+	memcpy(ref, dst, n * sizeof(uint32_t));
+
+	start = now();
+	for (i = 0; i < iterations; i++) {
+		premultiply_sse2(dst, src, n);
+	}
+	report("premultiply sse2", now() - start,
+			!memcmp(dst, ref, n * sizeof(uint32_t)));
+#endif
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# bench_startup.sh - measure xsysguard startup time on synthetic configs
+#
+# Usage: bench_startup.sh [xsysguard] [module path] [sizes...]
+#
+# For each size N a configuration with N Text widgets, N/4 LineCharts and
+# N/4 Rectangles is generated and xsysguard is run once with --num 1 and
+# --profile. The "startup" and "init" lines of the profile show the time
+# spent parsing the configuration and running the init functions.
+#
+# Needs an X server, xvfb-run is used when DISPLAY is not set.
+
+XSYSGUARD=${1:-src/xsysguard}
+MODULE_PATH=${2:-src/modules}
+shift 2 2>/dev/null
+SIZES=${*:-1000 2000 4000 8000}
+
+TMPDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMPDIR"' EXIT
+
+if [ -z "$DISPLAY" ]; then
+	RUN="xvfb-run -a"
+else
+	RUN=""
+fi
+
+gen_config() {
+	echo "Set Size 800 600"
+	echo "Set Background Color black"
+	i=0
+	while [ $i -lt $1 ]; do
+		x=$((i % 40 * 20))
+		y=$((i / 40 % 30 * 20))
+		echo "Text 1 $x $y 20 20 white DejaVuSans/6 \"%.0f %s\""
+		echo "+ random,100,MUL,DUP,1,EXC,STORE:$((i % 8))"
+		echo "+ env:HOME:read:all"
+		if [ $((i % 4)) -eq 0 ]; then
+			echo "LineChart 1 $x $y 20 20 Min 0 Max 1"
+			echo "+ random,tick,2,MOD,ADD red"
+			echo "Rectangle $x $y 20 20 #202020"
+		fi
+		i=$((i + 1))
+	done
+}
+
+for n in $SIZES; do
+	gen_config "$n" > "$TMPDIR/bench_$n"
+	echo "*** $n widgets ($(wc -l < "$TMPDIR/bench_$n") lines)"
+	start=$(date +%s%N)
+	XSYSGUARD_MODULE_PATH="$MODULE_PATH" $RUN "$XSYSGUARD" -p -n 1 \
+		"$TMPDIR/bench_$n" 2>&1 | grep -E "^(category|startup|init) "
+	end=$(date +%s%N)
+	echo "wall: $(((end - start) / 1000000)) ms"
+done
@@ -0,0 +1,500 @@
+/* bench_update.c
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Replays dirty rectangle traces through the damage tracker of src/update.c
+ * and through the old recursive merge. For each trace and rect cost the time
+ * per frame, the number of rects, the number of rendered pixels and the
+ * modelled cost (the rect cost per rect plus the pixels) are printed. The
+ * tracker output is checked to cover every damaged pixel. Build and run with
+ * "make bench-update".
+ *
+ * Usage: bench_update [-c rect_cost]... [trace...]
+ *
+ * Without -c the per rect costs used by src/window.c are replayed.
+ *
+ * Without arguments some synthetic traces are replayed. A trace file starts
+ * with the window size "<width> <height>", followed by one "<x> <y> <w> <h>"
+ * line per damaged rect, a line "-" ends a frame.
+ */
+
+#include "../src/update.c"
+
+#include <stdio.h>
+#include <time.h>
+
+/******************************************************************************/
+
+int xsg_log_level = 0;
+
+void
+xsg_log(const char *domain, int level, const char *format, ...)
+{
+}
+
+void
+xsg_main_set_time_error(void)
+{
+}
+
+/******************************************************************************/
+
+typedef struct _trace_t {
+	const char *name;
+	int width;
+	int height;
+	unsigned frames;
+	unsigned *counts;
+	rect_t *rects;
+	unsigned length;
+} trace_t;
+
+static unsigned repeat = 20;
+
+static int costs[16] = { 256, 1024 };
+static unsigned num_costs = 2;
+
+/******************************************************************************/
+
+static uint64_t
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+trace_add(trace_t *trace, int x, int y, int w, int h)
+{
+	rect_t *rect;
+
+	trace->rects = xsg_renew(rect_t, trace->rects, trace->length + 1);
+	trace->counts[trace->frames - 1]++;
+
+	rect = trace->rects + trace->length++;
+	rect->xoffset = x;
+	rect->yoffset = y;
+	rect->width = w;
+	rect->height = h;
+}
+
+static void
+trace_frame(trace_t *trace)
+{
+	trace->counts = xsg_renew(unsigned, trace->counts, trace->frames + 1);
+	trace->counts[trace->frames++] = 0;
+}
+
+static trace_t *
+trace_new(const char *name, int width, int height)
+{
+	trace_t *trace = xsg_new0(trace_t, 1);
+
+	trace->name = name;
+	trace->width = width;
+	trace->height = height;
+
+	return trace;
+}
+
+/******************************************************************************/
+
+static trace_t *
+trace_read(const char *filename)
+{
+	trace_t *trace;
+	char line[256];
+	int x, y, w, h;
+	FILE *f;
+
+	if ((f = fopen(filename, "r")) == NULL) {
+		perror(filename);
+		exit(EXIT_FAILURE);
+	}
+
+	if (fgets(line, sizeof(line), f) == NULL
+			|| sscanf(line, "%d %d", &w, &h) != 2) {
+		fprintf(stderr, "%s: window size expected\n", filename);
+		exit(EXIT_FAILURE);
+	}
+
+	trace = trace_new(filename, w, h);
+	trace_frame(trace);
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '-' && (line[1] == '\n' || line[1] == '\0')) {
+			trace_frame(trace);
+		} else if (sscanf(line, "%d %d %d %d", &x, &y, &w, &h) == 4) {
+			trace_add(trace, x, y, w, h);
+		}
+	}
+
+	fclose(f);
+
+	return trace;
+}
+
+/* a grid of 10x20 text widgets, about a third changes every frame */
+static trace_t *
+trace_text_grid(void)
+{
+	trace_t *trace = trace_new("text grid 800x600", 800, 600);
+	unsigned frame, i;
+
+	for (frame = 0; frame < 200; frame++) {
+		trace_frame(trace);
+		for (i = 0; i < 200; i++) {
+			if (rand() % 3 == 0) {
+				trace_add(trace, 4 + (i % 10) * 79,
+						4 + (i / 10) * 29, 75, 25);
+			}
+		}
+	}
+
+	return trace;
+}
+
+/* four scrolling charts and their value labels */
+static trace_t *
+trace_charts(void)
+{
+	trace_t *trace = trace_new("charts 800x600", 800, 600);
+	unsigned frame, i;
+
+	for (frame = 0; frame < 200; frame++) {
+		trace_frame(trace);
+		for (i = 0; i < 4; i++) {
+			int x = 10 + (i % 2) * 395, y = 10 + (i / 2) * 295;
+
+			trace_add(trace, x, y, 385, 260);
+			trace_add(trace, x + 300, y + 265, 85, 20);
+		}
+	}
+
+	return trace;
+}
+
+/* two small clocks in opposite corners of a full screen overlay */
+static trace_t *
+trace_corners(void)
+{
+	trace_t *trace = trace_new("corners 1920x1080", 1920, 1080);
+	unsigned frame;
+
+	for (frame = 0; frame < 200; frame++) {
+		trace_frame(trace);
+		trace_add(trace, 10, 10, 120, 30);
+		trace_add(trace, 1790, 1040, 120, 30);
+	}
+
+	return trace;
+}
+
+/* many small overlapping widgets all over a full screen overlay */
+static trace_t *
+trace_scattered(void)
+{
+	trace_t *trace = trace_new("scattered 1920x1080", 1920, 1080);
+	unsigned frame, i;
+
+	for (frame = 0; frame < 200; frame++) {
+		trace_frame(trace);
+		for (i = 0; i < 100; i++) {
+			trace_add(trace, rand() % 1900, rand() % 1060,
+					8 + rand() % 60, 8 + rand() % 20);
+		}
+	}
+
+	return trace;
+}
+
+/* a dense grid of 40x50 small text widgets, half of them change every
+ * frame: more rects than MAX_CANDIDATES, so the tiles are used */
+static trace_t *
+trace_dense_grid(void)
+{
+	trace_t *trace = trace_new("dense grid 1920x1080", 1920, 1080);
+	unsigned frame, i;
+
+	for (frame = 0; frame < 25; frame++) {
+		trace_frame(trace);
+		for (i = 0; i < 2000; i++) {
+			if (rand() % 2 == 0) {
+				trace_add(trace, 8 + (i % 40) * 48,
+						8 + (i / 40) * 21, 44, 17);
+			}
+		}
+	}
+
+	return trace;
+}
+
+/******************************************************************************/
+
+/* the old xsg_update_append_rect */
+static xsg_list_t *
+old_append_rect(xsg_list_t *updates, int x, int y, int w, int h)
+{
+	int x1_1, x2_1, y1_1, y2_1;
+	xsg_list_t *l;
+	rect_t *rect;
+
+	if (w < 1 || h < 1) {
+		return updates;
+	}
+
+	x1_1 = x;
+	x2_1 = x + w;
+	y1_1 = y;
+	y2_1 = y + h;
+
+	for (l = updates; l; l = l->next) {
+		int x1_2, x2_2, y1_2, y2_2;
+		bool x_overlap, y_overlap;
+
+		rect = l->data;
+
+		x1_2 = rect->xoffset;
+		x2_2 = rect->xoffset + rect->width;
+		y1_2 = rect->yoffset;
+		y2_2 = rect->yoffset + rect->height;
+
+		x_overlap = !((x2_2 <= x1_1) || (x2_1 <= x1_2));
+		y_overlap = !((y2_2 <= y1_1) || (y2_1 <= y1_2));
+
+		if (x_overlap && y_overlap) {
+			xsg_free(rect);
+			updates = xsg_list_delete_link(updates, l);
+			x = MIN(x1_1, x1_2);
+			y = MIN(y1_1, y1_2);
+			w = MAX(x2_1, x2_2) - x;
+			h = MAX(y2_1, y2_2) - y;
+			return old_append_rect(updates, x, y, w, h);
+		}
+	}
+
+	rect = xsg_new(rect_t, 1);
+	rect->xoffset = x;
+	rect->yoffset = y;
+	rect->width = w;
+	rect->height = h;
+
+	updates = xsg_list_prepend(updates, rect);
+
+	return updates;
+}
+
+/******************************************************************************/
+
+typedef struct _stats_t {
+	uint64_t nsec;
+	uint64_t rects;
+	uint64_t pixels;
+	uint64_t cost;
+} stats_t;
+
+static void
+account(stats_t *stats, xsg_list_t *rects, int rect_cost)
+{
+	xsg_list_t *l;
+
+	for (l = rects; l; l = l->next) {
+		rect_t *rect = l->data;
+
+		stats->rects++;
+		stats->pixels += (uint64_t) rect->width * rect->height;
+		stats->cost += rect_cost
+			+ (uint64_t) rect->width * rect->height;
+	}
+}
+
+static void
+report(const char *name, trace_t *trace, stats_t *stats)
+{
+	printf("  %-8s %10.3f us/frame %8.1f rects %12.0f pixels %12.0f cost\n",
+			name, (double) stats->nsec / repeat / trace->frames
+			/ 1000.0, (double) stats->rects / trace->frames,
+			(double) stats->pixels / trace->frames,
+			(double) stats->cost / trace->frames);
+}
+
+/* every damaged pixel inside the window must be covered */
+static bool
+check(trace_t *trace, rect_t *damage, unsigned count, xsg_list_t *rects)
+{
+	uint8_t *map = xsg_new0(uint8_t, trace->width * trace->height);
+	bool ok = TRUE;
+	xsg_list_t *l;
+	unsigned i;
+	int x, y;
+
+	for (l = rects; l; l = l->next) {
+		rect_t *rect = l->data;
+
+		if (rect->xoffset < 0 || rect->yoffset < 0
+		 || rect->xoffset + rect->width > trace->width
+		 || rect->yoffset + rect->height > trace->height) {
+			ok = FALSE;
+			continue;
+		}
+
+		for (y = rect->yoffset; y < rect->yoffset + rect->height; y++) {
+			memset(map + y * trace->width + rect->xoffset, 1,
+					rect->width);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		rect_t *d = damage + i;
+
+		for (y = MAX(d->yoffset, 0);
+		     y < MIN(d->yoffset + d->height, trace->height); y++) {
+			for (x = MAX(d->xoffset, 0);
+			     x < MIN(d->xoffset + d->width, trace->width);
+			     x++) {
+				ok = ok && map[y * trace->width + x];
+			}
+		}
+	}
+
+	xsg_free(map);
+
+	return ok;
+}
+
+static bool
+replay_cost(trace_t *trace, int rect_cost)
+{
+	xsg_update_t *update;
+	stats_t old = { 0 }, new = { 0 };
+	unsigned frame, i, r;
+	bool ok = TRUE;
+
+	update = xsg_update_new(trace->width, trace->height, rect_cost);
+
+	printf("  rect cost %d\n", rect_cost);
+
+	for (r = 0; r < repeat; r++) {
+		rect_t *rect = trace->rects;
+
+		for (frame = 0; frame < trace->frames; frame++) {
+			xsg_list_t *rects = NULL;
+			uint64_t start = now();
+
+			for (i = 0; i < trace->counts[frame]; i++) {
+				rects = old_append_rect(rects, rect[i].xoffset,
+						rect[i].yoffset, rect[i].width,
+						rect[i].height);
+			}
+
+			old.nsec += now() - start;
+
+			if (r == 0) {
+				account(&old, rects, rect_cost);
+			}
+
+			xsg_update_free(rects);
+
+			start = now();
+
+			for (i = 0; i < trace->counts[frame]; i++) {
+				xsg_update_append_rect(update, rect[i].xoffset,
+						rect[i].yoffset, rect[i].width,
+						rect[i].height);
+			}
+
+			rects = xsg_update_get_rects(update);
+
+			new.nsec += now() - start;
+
+			if (r == 0) {
+				account(&new, rects, rect_cost);
+				ok = ok && check(trace, rect,
+						trace->counts[frame], rects);
+			}
+
+			xsg_update_free(rects);
+
+			rect += trace->counts[frame];
+		}
+	}
+
+	report("old", trace, &old);
+	report("update", trace, &new);
+
+	if (!ok) {
+		printf("  MISMATCH: damaged pixels not covered\n");
+	}
+
+	return ok;
+}
+
+static bool
+replay(trace_t *trace)
+{
+	bool ok = TRUE;
+	unsigned i;
+
+	printf("%s: %u frames, %.1f rects/frame\n", trace->name,
+			trace->frames, (double) trace->length / trace->frames);
+
+	for (i = 0; i < num_costs; i++) {
+		ok = replay_cost(trace, costs[i]) && ok;
+	}
+
+	return ok;
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	bool ok = TRUE;
+	int i;
+
+	srand(1);
+
+	for (i = 1; i + 1 < argc && strcmp(argv[i], "-c") == 0; i += 2) {
+		if (i == 1) {
+			num_costs = 0;
+		}
+		if (num_costs < sizeof(costs) / sizeof(costs[0])) {
+			costs[num_costs++] = atoi(argv[i + 1]);
+		}
+	}
+
+	if (i < argc) {
+		for (; i < argc; i++) {
+			ok = replay(trace_read(argv[i])) && ok;
+		}
+	} else {
+		ok = replay(trace_text_grid()) && ok;
+		ok = replay(trace_charts()) && ok;
+		ok = replay(trace_corners()) && ok;
+		ok = replay(trace_scattered()) && ok;
+		ok = replay(trace_dense_grid()) && ok;
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
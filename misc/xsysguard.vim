@@ -23,12 +23,12 @@ syn keyword xsysguardCommand Polygon Image BarChart LineChart AreaChart Text
 syn keyword xsysguardSubCommand Name Class Resource Size Position Sticky
 syn keyword xsysguardSubCommand SkipTaskbar SkipPager Layer Decorations
 syn keyword xsysguardSubCommand OverrideRedirect Background XShape ARGBVisual
-syn keyword xsysguardSubCommand Visible Mouse Overwrite
+syn keyword xsysguardSubCommand FrameRate Visible Mouse Overwrite
 syn keyword xsysguardSubCommand Angle ColorRange Filled Closed Min Max Mask
-syn keyword xsysguardSubCommand AddPrev Background Top Alignment TabWidth
+syn keyword xsysguardSubCommand AddPrev Background Top Alignment TabWidth Vector
 
 syn keyword xsysguardValue on off On Off true false True False
-syn keyword xsysguardValue Above Normal Below Move Exit
+syn keyword xsysguardValue Above Normal Below Move Exit Tick
 syn keyword xsysguardValue CopyFromParent CopyFromRoot Color
 syn keyword xsysguardValue TopLeft TopCenter TopRight CenterLeft Center
 syn keyword xsysguardValue CenterRight BottomLeft BottomCenter BottomRight
@@ -43,7 +43,10 @@ syn keyword xsysguardRpnOp ATOF ATOI ATOL ATOLL STRTOF STRTOD STRTOLD
 syn keyword xsysguardRpnOp STRTOL STRTOLL STRTOUL STRTOULL
 syn keyword xsysguardRpnOp STRLEN STRCMP STRCASECMP STRUP STRDOWN STRREVERSE
 syn keyword xsysguardRpnOp STRCHUG STRCHOMP STRTRUNCATE
-syn keyword xsysguardRpnOp LOAD STORE
+syn keyword xsysguardRpnOp DELTA RATE EWMA WINAVG WINMIN WINMAX
+syn keyword xsysguardRpnOp VADD VSUB VMUL VDIV VSUM VAVG VMIN VMAX VLEN VGET
+syn keyword xsysguardRpnOp VDELTA
+syn keyword xsysguardRpnOp LOAD STORE GLOAD GSTORE
 
 syn match xsysguardComment "^\s*#.*$" contains=xsysguardTodo
 
@@ -0,0 +1,385 @@
+/* argb.c
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Pixel kernels for imlib's ARGB32 data. Each kernel has a plain C version,
+ * the SSE2 version is used if the compiler targets SSE2 (always on x86-64).
+ * The mask kernels also have an AVX2 version, which is selected at runtime
+ * if the cpu supports it.
+ */
+
+#include <xsysguard.h>
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+# define HAVE_AVX2 1
+# include <immintrin.h>
+#endif
+
+#include "argb.h"
+
+/******************************************************************************/
+
+#ifdef HAVE_AVX2
+# define AVX2 __attribute__((target("avx2")))
+
+static bool
+have_avx2(void)
+{
+	static int avx2 = -1;
+
+	if (unlikely(avx2 < 0)) {
+		__builtin_cpu_init();
+		avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+	}
+
+	return avx2;
+}
+#endif
+
+/******************************************************************************/
+
+/* x * a / 255, rounded, for two 8 bit channels in the 16 bit lanes of v */
+#define MUL_DIV255_2X(v, a) \
+	({ uint32_t _t = (v) * (a) + 0x00800080; \
+	   ((_t + ((_t >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff; })
+
+static void
+premultiply_c(uint32_t *dst, const uint32_t *src, unsigned n)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++) {
+		uint32_t p = src[i];
+		uint32_t a = p >> 24;
+		uint32_t rb, g;
+
+		rb = MUL_DIV255_2X(p & 0x00ff00ff, a);
+		g = MUL_DIV255_2X((p >> 8) & 0x000000ff, a);
+
+		dst[i] = (a << 24) | (g << 8) | rb;
+	}
+}
+
+#ifdef __SSE2__
+
+/* four pixels at once, the channels are widened to 16 bit lanes and
+ * multiplied with the alpha of their pixel, the alpha itself is kept */
+static void
+premultiply_sse2(uint32_t *dst, const uint32_t *src, unsigned n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(0x80);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	unsigned i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i p, lo, hi, a;
+
+		p = _mm_loadu_si128((const __m128i *) (src + i));
+
+		lo = _mm_unpacklo_epi8(p, zero);
+		a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+		lo = _mm_add_epi16(_mm_mullo_epi16(lo, a), round);
+		lo = _mm_add_epi16(lo, _mm_srli_epi16(lo, 8));
+		lo = _mm_srli_epi16(lo, 8);
+
+		hi = _mm_unpackhi_epi8(p, zero);
+		a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+		hi = _mm_add_epi16(_mm_mullo_epi16(hi, a), round);
+		hi = _mm_add_epi16(hi, _mm_srli_epi16(hi, 8));
+		hi = _mm_srli_epi16(hi, 8);
+
+		lo = _mm_packus_epi16(lo, hi);
+		lo = _mm_or_si128(_mm_andnot_si128(alpha, lo),
+				_mm_and_si128(alpha, p));
+
+		_mm_storeu_si128((__m128i *) (dst + i), lo);
+	}
+
+	premultiply_c(dst + i, src + i, n - i);
+}
+
+#endif /* __SSE2__ */
+
+void
+xsg_argb_premultiply(uint32_t *dst, const uint32_t *src, unsigned n)
+{
+#ifdef __SSE2__
+	premultiply_sse2(dst, src, n);
+#else
+	premultiply_c(dst, src, n);
+#endif
+}
+
+/******************************************************************************
+ *
+ * alpha threshold to bitmask
+ *
+ ******************************************************************************/
+
+static void
+mask_bits_c(
+	uint8_t *mask,
+	const uint32_t *src,
+	unsigned n,
+	unsigned threshold,
+	bool msb_first
+)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i += 8) {
+		unsigned j, end = MIN(n - i, 8);
+		unsigned m = 0;
+
+		for (j = 0; j < end; j++) {
+			m |= ((src[i + j] >> 24) >= threshold) << j;
+		}
+
+		if (msb_first) {
+			m = ((m * 0x0802 & 0x22110) | (m * 0x8020 & 0x88440))
+				* 0x10101 >> 16;
+		}
+
+		*mask++ = m;
+	}
+}
+
+#ifdef __SSE2__
+
+/* the comparison results of 16 pixels are narrowed to bytes, movemask
+ * collects their sign bits: pixel 0 ends up in bit 0 (lsb first) */
+static unsigned
+mask_bits_sse2(uint8_t *mask, const uint32_t *src, unsigned n,
+		unsigned threshold)
+{
+	const __m128i t = _mm_set1_epi32(threshold - 1);
+	unsigned i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i c0, c1, c2, c3;
+		unsigned bits;
+
+		c0 = _mm_loadu_si128((const __m128i *) (src + i));
+		c1 = _mm_loadu_si128((const __m128i *) (src + i + 4));
+		c2 = _mm_loadu_si128((const __m128i *) (src + i + 8));
+		c3 = _mm_loadu_si128((const __m128i *) (src + i + 12));
+
+		c0 = _mm_cmpgt_epi32(_mm_srli_epi32(c0, 24), t);
+		c1 = _mm_cmpgt_epi32(_mm_srli_epi32(c1, 24), t);
+		c2 = _mm_cmpgt_epi32(_mm_srli_epi32(c2, 24), t);
+		c3 = _mm_cmpgt_epi32(_mm_srli_epi32(c3, 24), t);
+
+		c0 = _mm_packs_epi16(_mm_packs_epi32(c0, c1),
+				_mm_packs_epi32(c2, c3));
+
+		bits = _mm_movemask_epi8(c0);
+
+		mask[i / 8] = bits;
+		mask[i / 8 + 1] = bits >> 8;
+	}
+
+	return i;
+}
+
+#endif /* __SSE2__ */
+
+#ifdef HAVE_AVX2
+
+/* the packs work within 128 bit lanes, the permutation restores the pixel
+ * order before movemask */
+static AVX2 unsigned
+mask_bits_avx2(uint8_t *mask, const uint32_t *src, unsigned n,
+		unsigned threshold)
+{
+	const __m256i t = _mm256_set1_epi32(threshold - 1);
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	unsigned i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i c0, c1, c2, c3;
+		uint32_t bits;
+
+		c0 = _mm256_loadu_si256((const __m256i *) (src + i));
+		c1 = _mm256_loadu_si256((const __m256i *) (src + i + 8));
+		c2 = _mm256_loadu_si256((const __m256i *) (src + i + 16));
+		c3 = _mm256_loadu_si256((const __m256i *) (src + i + 24));
+
+		c0 = _mm256_cmpgt_epi32(_mm256_srli_epi32(c0, 24), t);
+		c1 = _mm256_cmpgt_epi32(_mm256_srli_epi32(c1, 24), t);
+		c2 = _mm256_cmpgt_epi32(_mm256_srli_epi32(c2, 24), t);
+		c3 = _mm256_cmpgt_epi32(_mm256_srli_epi32(c3, 24), t);
+
+		c0 = _mm256_packs_epi16(_mm256_packs_epi32(c0, c1),
+				_mm256_packs_epi32(c2, c3));
+		c0 = _mm256_permutevar8x32_epi32(c0, order);
+
+		bits = _mm256_movemask_epi8(c0);
+
+		mask[i / 8] = bits;
+		mask[i / 8 + 1] = bits >> 8;
+		mask[i / 8 + 2] = bits >> 16;
+		mask[i / 8 + 3] = bits >> 24;
+	}
+
+	return i;
+}
+
+#endif /* HAVE_AVX2 */
+
+void
+xsg_argb_mask_bits(
+	uint8_t *mask,
+	const uint32_t *src,
+	unsigned n,
+	unsigned threshold,
+	bool msb_first
+)
+{
+	unsigned i = 0;
+
+	if (!msb_first) {
+#ifdef HAVE_AVX2
+		if (have_avx2()) {
+			i = mask_bits_avx2(mask, src, n, threshold);
+		}
+#endif
+#ifdef __SSE2__
+		i += mask_bits_sse2(mask + i / 8, src + i, n - i, threshold);
+#endif
+	}
+
+	mask_bits_c(mask + i / 8, src + i, n - i, threshold, msb_first);
+}
+
+/******************************************************************************
+ *
+ * multiply with mask
+ *
+ ******************************************************************************/
+
+static void
+mul_c(uint32_t *dst, const uint32_t *mask, unsigned n)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++) {
+		uint8_t *d = (uint8_t *) (dst + i);
+		const uint8_t *m = (const uint8_t *) (mask + i);
+
+		d[0] = (d[0] * m[0]) / 0xff;
+		d[1] = (d[1] * m[1]) / 0xff;
+		d[2] = (d[2] * m[2]) / 0xff;
+		d[3] = (d[3] * m[3]) / 0xff;
+	}
+}
+
+#ifdef __SSE2__
+
+static unsigned
+mul_sse2(uint32_t *dst, const uint32_t *mask, unsigned n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	unsigned i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i d, m, lo, hi;
+
+		d = _mm_loadu_si128((const __m128i *) (dst + i));
+		m = _mm_loadu_si128((const __m128i *) (mask + i));
+
+		lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero),
+				_mm_unpacklo_epi8(m, zero));
+		hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero),
+				_mm_unpackhi_epi8(m, zero));
+
+		lo = _mm_add_epi16(_mm_add_epi16(lo, one),
+				_mm_srli_epi16(lo, 8));
+		hi = _mm_add_epi16(_mm_add_epi16(hi, one),
+				_mm_srli_epi16(hi, 8));
+
+		d = _mm_packus_epi16(_mm_srli_epi16(lo, 8),
+				_mm_srli_epi16(hi, 8));
+
+		_mm_storeu_si128((__m128i *) (dst + i), d);
+	}
+
+	return i;
+}
+
+#endif /* __SSE2__ */
+
+#ifdef HAVE_AVX2
+
+/* unpack and pack both work within 128 bit lanes, the order is kept */
+static AVX2 unsigned
+mul_avx2(uint32_t *dst, const uint32_t *mask, unsigned n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16(1);
+	unsigned i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i d, m, lo, hi;
+
+		d = _mm256_loadu_si256((const __m256i *) (dst + i));
+		m = _mm256_loadu_si256((const __m256i *) (mask + i));
+
+		lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero),
+				_mm256_unpacklo_epi8(m, zero));
+		hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero),
+				_mm256_unpackhi_epi8(m, zero));
+
+		lo = _mm256_add_epi16(_mm256_add_epi16(lo, one),
+				_mm256_srli_epi16(lo, 8));
+		hi = _mm256_add_epi16(_mm256_add_epi16(hi, one),
+				_mm256_srli_epi16(hi, 8));
+
+		d = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8),
+				_mm256_srli_epi16(hi, 8));
+
+		_mm256_storeu_si256((__m256i *) (dst + i), d);
+	}
+
+	return i;
+}
+
+#endif /* HAVE_AVX2 */
+
+void
+xsg_argb_mul(uint32_t *dst, const uint32_t *mask, unsigned n)
+{
+	unsigned i = 0;
+
+#ifdef HAVE_AVX2
+	if (have_avx2()) {
+		i = mul_avx2(dst, mask, n);
+	}
+#endif
+#ifdef __SSE2__
+	i += mul_sse2(dst + i, mask + i, n - i);
+#endif
+
+	mul_c(dst + i, mask + i, n - i);
+}
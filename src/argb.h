@@ -32,7 +32,7 @@
 
 /******************************************************************************/
 
-static bool
+static inline bool
 xsg_argb_am_big_endian(void)
 {
 	long one = 1;
@@ -41,5 +41,22 @@ xsg_argb_am_big_endian(void)
 
 /******************************************************************************/
 
+extern void
+xsg_argb_premultiply(uint32_t *dst, const uint32_t *src, unsigned n);
+
+extern void
+xsg_argb_mask_bits(
+	uint8_t *mask,
+	const uint32_t *src,
+	unsigned n,
+	unsigned threshold,
+	bool msb_first
+);
+
+extern void
+xsg_argb_mul(uint32_t *dst, const uint32_t *mask, unsigned n);
+
+/******************************************************************************/
+
 #endif /* __ARGB_H__ */
 
@@ -23,6 +23,7 @@
  * read:sscanf:<format>
  * read:nscanf:<format>
  * read:cscanf:<format>
+ * read:vscanf:<format>
  * read:grep:<pattern>:<index>
  * read:igrep:<pattern>:<index>
  *
@@ -30,6 +31,7 @@
  * readline:<number>:sscanf:<format>
  * readline:<number>:nscanf:<format>
  * readline:<number>:cscanf:<format>
+ * readline:<number>:vscanf:<format>
  * readline:<number>:grep:<pattern>:<index>
  * readline:<number>:igrep:<pattern>:<index>
  */
@@ -38,6 +40,7 @@
 
 #include <xsysguard.h>
 #include <regex.h>
+#include <string.h>
 
 #include "scanf.h"
 
@@ -278,11 +281,90 @@ parse_cscanf(xsg_buffer_t *buffer, xsg_var_t *var)
 
 /******************************************************************************/
 
+/* scans each line, the matching numbers form a vector */
+typedef struct _vscanf_t {
+	xsg_var_t *var;
+	double *values;
+	unsigned len;
+	unsigned size;
+	char *format;
+} vscanf_t;
+
+static double
+get_vscanf(void *arg)
+{
+	vscanf_t *vscanf = (vscanf_t *) arg;
+
+	return (double) vscanf->len;
+}
+
+static const double *
+get_vscanf_vector(void *arg, unsigned *len)
+{
+	vscanf_t *vscanf = (vscanf_t *) arg;
+
+	*len = vscanf->len;
+
+	return vscanf->values;
+}
+
+static void
+process_vscanf(void *arg, xsg_string_t *string)
+{
+	vscanf_t *vscanf = (vscanf_t *) arg;
+	const char *line = string->str;
+
+	vscanf->len = 0;
+
+	while (line != NULL && line[0] != '\0') {
+		double *n;
+
+		n = xsg_scanf_number(line, vscanf->format);
+
+		if (n != NULL) {
+			if (vscanf->len == vscanf->size) {
+				vscanf->size = MAX(8, vscanf->size * 2);
+				vscanf->values = xsg_renew(double,
+						vscanf->values, vscanf->size);
+			}
+			vscanf->values[vscanf->len++] = *n;
+		}
+
+		line = strchr(line, '\n');
+
+		if (line != NULL) {
+			line++;
+		}
+	}
+
+	if (vscanf->var) {
+		xsg_var_dirty(vscanf->var);
+	}
+}
+
+static void *
+parse_vscanf(xsg_buffer_t *buffer, xsg_var_t *var)
+{
+	vscanf_t *vscanf;
+
+	vscanf = xsg_new(vscanf_t, 1);
+	vscanf->var = var;
+	vscanf->values = NULL;
+	vscanf->len = 0;
+	vscanf->size = 0;
+	vscanf->format = xsg_conf_read_string();
+
+	return (void *) vscanf;
+}
+
+/******************************************************************************/
+
 typedef struct _re_t {
 	xsg_var_t *var;
 	xsg_string_t *string;
 	char *pattern;
 	int index;
+	int cflags;
 	regex_t *regex;
 } re_t;
 
@@ -344,6 +426,8 @@ parse_re(xsg_buffer_t *buffer, xsg_var_t *var, bool ignore_case)
 	cflags |= (re->index < 0) ? REG_NOSUB : 0;
 	cflags |= ignore_case ? REG_ICASE : 0;
 
+	re->cflags = cflags;
+
 	errcode = regcomp(re->regex, re->pattern, cflags);
 
 	if (unlikely(errcode != 0)) {
@@ -362,6 +446,118 @@ parse_re(xsg_buffer_t *buffer, xsg_var_t *var, bool ignore_case)
 
 /******************************************************************************/
 
+/* Identical sources without var are parsed once and share their arg, so
+ * the samples cached by xsg_rpn_set_pure are shared as well. */
+
+static bool
+same_source(void (*func)(void *, xsg_string_t *), void *a, void *b)
+{
+	if (func == process_all) {
+		return TRUE;
+	} else if (func == process_sscanf) {
+		return !strcmp(((sscanf_t *) a)->format,
+				((sscanf_t *) b)->format);
+	} else if (func == process_nscanf) {
+		return !strcmp(((nscanf_t *) a)->format,
+				((nscanf_t *) b)->format);
+	} else if (func == process_cscanf) {
+		return !strcmp(((cscanf_t *) a)->format,
+				((cscanf_t *) b)->format);
+	} else if (func == process_vscanf) {
+		return !strcmp(((vscanf_t *) a)->format,
+				((vscanf_t *) b)->format);
+	} else if (func == process_re) {
+		re_t *re_a = (re_t *) a;
+		re_t *re_b = (re_t *) b;
+
+		return re_a->index == re_b->index
+			&& re_a->cflags == re_b->cflags
+			&& !strcmp(re_a->pattern, re_b->pattern);
+	}
+
+	return FALSE;
+}
+
+static void
+free_source(void (*func)(void *, xsg_string_t *), void *arg)
+{
+	if (func == process_all) {
+		xsg_string_free(((all_t *) arg)->string, TRUE);
+	} else if (func == process_sscanf) {
+		xsg_string_free(((sscanf_t *) arg)->string, TRUE);
+		xsg_free(((sscanf_t *) arg)->format);
+	} else if (func == process_nscanf) {
+		xsg_free(((nscanf_t *) arg)->format);
+	} else if (func == process_cscanf) {
+		xsg_free(((cscanf_t *) arg)->format);
+	} else if (func == process_vscanf) {
+		xsg_free(((vscanf_t *) arg)->values);
+		xsg_free(((vscanf_t *) arg)->format);
+	} else if (func == process_re) {
+		re_t *re = (re_t *) arg;
+
+		xsg_string_free(re->string, TRUE);
+		xsg_free(re->pattern);
+		regfree(re->regex);
+		xsg_free(re->regex);
+	}
+
+	xsg_free(arg);
+}
+
+static void *
+share_source(xsg_buffer_t *buffer, void *arg)
+{
+	xsg_list_t *l, *link = NULL;
+	readline_var_t *new_readline_var = NULL;
+	read_var_t *new_read_var = NULL;
+
+	for (l = buffer->read_var_list; l; l = l->next) {
+		if (((read_var_t *) l->data)->arg == arg) {
+			new_read_var = l->data;
+			link = l;
+		}
+	}
+
+	for (l = buffer->read_var_list; l && new_read_var; l = l->next) {
+		read_var_t *read_var = l->data;
+
+		if (l != link && read_var->func == new_read_var->func
+		 && same_source(read_var->func, read_var->arg, arg)) {
+			buffer->read_var_list = xsg_list_delete_link(
+					buffer->read_var_list, link);
+			free_source(new_read_var->func, arg);
+			xsg_free(new_read_var);
+			return read_var->arg;
+		}
+	}
+
+	for (l = buffer->readline_var_list; l; l = l->next) {
+		if (((readline_var_t *) l->data)->arg == arg) {
+			new_readline_var = l->data;
+			link = l;
+		}
+	}
+
+	for (l = buffer->readline_var_list; l && new_readline_var; l = l->next) {
+		readline_var_t *readline_var = l->data;
+
+		if (l != link && readline_var->func == new_readline_var->func
+		 && readline_var->number == new_readline_var->number
+		 && same_source(readline_var->func, readline_var->arg, arg)) {
+			buffer->readline_var_list = xsg_list_delete_link(
+					buffer->readline_var_list, link);
+			free_source(new_readline_var->func, arg);
+			xsg_free(new_readline_var);
+			return readline_var->arg;
+		}
+	}
+
+	return arg;
+}
+
+/******************************************************************************/
+
 void
 xsg_buffer_parse(
 	xsg_buffer_t *buffer,
@@ -427,10 +623,17 @@ xsg_buffer_parse(
 				*arg = parse_cscanf(buffer, var);
 				read_var->func = process_cscanf;
 				read_var->arg = *arg;
+			} else if (xsg_conf_find_command("vector")
+				|| xsg_conf_find_command("vec")
+				|| xsg_conf_find_command("v")) {
+				*num = get_vscanf;
+				*arg = parse_vscanf(buffer, var);
+				read_var->func = process_vscanf;
+				read_var->arg = *arg;
 			} else {
 				xsg_conf_error("string, str, s, number, num, "
-						"n, counter, count or c "
-						"expected");
+						"n, counter, count, c, "
+						"vector, vec or v expected");
 			}
 		} else if (xsg_conf_find_command("grep")) {
 			*str = get_re;
@@ -488,10 +691,17 @@ xsg_buffer_parse(
 				*arg = parse_cscanf(buffer, var);
 				readline_var->func = process_cscanf;
 				readline_var->arg = *arg;
+			} else if (xsg_conf_find_command("vector")
+				|| xsg_conf_find_command("vec")
+				|| xsg_conf_find_command("v")) {
+				*num = get_vscanf;
+				*arg = parse_vscanf(buffer, var);
+				readline_var->func = process_vscanf;
+				readline_var->arg = *arg;
 			} else {
 				xsg_conf_error("string, str, s, number, num, "
-						"n, counter, count or c "
-						"expected");
+						"n, counter, count, c, "
+						"vector, vec or v expected");
 			}
 		} else if (xsg_conf_find_command("grep")) {
 			*str = get_re;
@@ -510,6 +720,16 @@ xsg_buffer_parse(
 	} else {
 		xsg_conf_error("read or readline expected");
 	}
+
+	/* buffers without var are only filled by update functions */
+	if (var == NULL) {
+		*arg = share_source(buffer, *arg);
+		xsg_rpn_set_pure(*num, *str, *arg);
+	}
+
+	if (*num == get_vscanf) {
+		xsg_rpn_set_vector(*num, *arg, get_vscanf_vector);
+	}
 }
 
 /******************************************************************************/
@@ -597,6 +817,8 @@ xsg_buffer_help_helper(
 			opt, s, "scanf:number:<format>");
 	xsg_string_append_printf(string, "N %s:%s:%s:%s\n", module_name,
 			opt, s, "scanf:counter:<format>");
+	xsg_string_append_printf(string, "V %s:%s:%s:%s\n", module_name,
+			opt, s, "scanf:vector:<format>");
 	xsg_string_append_printf(string, "S %s:%s:%s:%s\n", module_name,
 			opt, s, "grep:<pattern>:<index>");
 	xsg_string_append_printf(string, "S %s:%s:%s:%s\n", module_name,
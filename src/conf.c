@@ -46,6 +46,33 @@ xsg_conf_set_buffer(char *name, char *buffer)
 
 /******************************************************************************/
 
+char *
+xsg_conf_get_location(void)
+{
+	char *begin, *end, *location;
+
+	if (log_name != NULL) {
+		xsg_asprintf(&location, "%s:%u", log_name, line);
+		return location;
+	}
+
+	for (begin = ptr; begin > buf && begin[-1] != '\n'; begin--) {
+		;
+	}
+
+	for (end = ptr; end[0] != '\0' && end[0] != '\n'; end++) {
+		;
+	}
+
+	location = xsg_new(char, end - begin + 1);
+	memcpy(location, begin, end - begin);
+	location[end - begin] = '\0';
+
+	return location;
+}
+
+/******************************************************************************/
+
 static char *
 error_line(void)
 {
@@ -269,6 +296,200 @@ xsg_conf_find_command(const char *command)
 	}
 }
 
+static uint32_t
+keyword_hash(const char *s, size_t len, uint32_t seed)
+{
+	uint32_t h = 2166136261U ^ (seed * 2654435761U);
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		h ^= (unsigned char) s[i];
+		h *= 16777619U;
+	}
+
+	return h;
+}
+
+static unsigned
+keyword_slot(xsg_conf_keywords_t *keywords, const char *s, size_t len,
+		uint32_t disp)
+{
+	return keyword_hash(s, len, disp) & keywords->mask;
+}
+
+static bool
+place_keywords(xsg_conf_keywords_t *keywords, unsigned *ids, unsigned n,
+		uint32_t disp)
+{
+	const char *name;
+	unsigned i, j, slot;
+
+	for (i = 0; i < n; i++) {
+		name = keywords->names[ids[i]];
+		slot = keyword_slot(keywords, name, strlen(name), disp);
+		if (keywords->slots[slot] >= 0) {
+			break;
+		}
+		keywords->slots[slot] = ids[i];
+	}
+
+	if (i == n) {
+		return TRUE;
+	}
+
+	for (j = 0; j < i; j++) {
+		name = keywords->names[ids[j]];
+		slot = keyword_slot(keywords, name, strlen(name), disp);
+		keywords->slots[slot] = -1;
+	}
+
+	return FALSE;
+}
+
+/* hash and displace: keywords are hashed into buckets first, then each
+ * bucket, largest first, gets a seed for the second hash that moves all its
+ * keywords into free slots, so a lookup needs exactly one probe */
+static void
+build_keywords(xsg_conf_keywords_t *keywords)
+{
+	unsigned count = keywords->count;
+	unsigned size = 4;
+	unsigned *bucket;
+	unsigned *ids;
+	unsigned i, j;
+
+	for (i = 0; i < count; i++) {
+		for (j = i + 1; j < count; j++) {
+			if (strcmp(keywords->names[i], keywords->names[j]) == 0) {
+				xsg_error("duplicate keyword: %s",
+						keywords->names[i]);
+			}
+		}
+	}
+
+	while (size < count * 2) {
+		size <<= 1;
+	}
+
+	bucket = xsg_new(unsigned, count);
+	ids = xsg_new(unsigned, count);
+
+	for (;;) {
+		unsigned buckets = size >> 2;
+		unsigned max = 0;
+		unsigned n, b;
+		bool ok = TRUE;
+
+		keywords->mask = size - 1;
+		keywords->disp = xsg_renew(unsigned, keywords->disp, buckets);
+		keywords->slots = xsg_renew(int, keywords->slots, size);
+
+		for (i = 0; i < size; i++) {
+			keywords->slots[i] = -1;
+		}
+
+		for (b = 0; b < buckets; b++) {
+			keywords->disp[b] = 0;
+		}
+
+		for (i = 0; i < count; i++) {
+			const char *name = keywords->names[i];
+
+			bucket[i] = keyword_hash(name, strlen(name), 0)
+				& (buckets - 1);
+		}
+
+		for (b = 0; b < buckets; b++) {
+			for (i = 0, n = 0; i < count; i++) {
+				if (bucket[i] == b) {
+					n++;
+				}
+			}
+			max = MAX(max, n);
+		}
+
+		for (n = max; n > 0 && ok; n--) {
+			for (b = 0; b < buckets && ok; b++) {
+				uint32_t disp;
+
+				for (i = 0, j = 0; i < count; i++) {
+					if (bucket[i] == b) {
+						ids[j++] = i;
+					}
+				}
+
+				if (j != n) {
+					continue;
+				}
+
+				for (disp = 1; disp < 0x10000; disp++) {
+					if (place_keywords(keywords, ids, n,
+							disp)) {
+						break;
+					}
+				}
+
+				if (disp < 0x10000) {
+					keywords->disp[b] = disp;
+				} else {
+					ok = FALSE;
+				}
+			}
+		}
+
+		if (ok) {
+			break;
+		}
+
+		size <<= 1;
+	}
+
+	xsg_free(ids);
+	xsg_free(bucket);
+}
+
+int
+xsg_conf_find_keyword(xsg_conf_keywords_t *keywords)
+{
+	const char *name;
+	unsigned buckets;
+	size_t len = 0;
+	uint32_t h;
+	int id;
+
+	skip_space();
+
+	while (isalnum((unsigned char) ptr[len]) || ptr[len] == '_') {
+		len++;
+	}
+
+	if (len == 0) {
+		return -1;
+	}
+
+	if (unlikely(keywords->slots == NULL)) {
+		build_keywords(keywords);
+	}
+
+	buckets = (keywords->mask + 1) >> 2;
+	h = keyword_hash(ptr, len, 0);
+	id = keywords->slots[keyword_slot(keywords, ptr, len,
+			keywords->disp[h & (buckets - 1)])];
+
+	if (id < 0) {
+		return -1;
+	}
+
+	name = keywords->names[id];
+
+	if (strncmp(name, ptr, len) != 0 || name[len] != '\0') {
+		return -1;
+	}
+
+	ptr += len;
+	return id;
+}
+
 bool
 xsg_conf_find_number(double *number_return)
 {
@@ -31,6 +31,10 @@ xsg_conf_set_buffer(char *name, char *buffer);
 extern void
 xsg_conf_set_color_lookup(bool (*func)(char *name, uint32_t *color));
 
+/* "<config>:<line>" or the current line if the config has no name */
+extern char *
+xsg_conf_get_location(void);
+
 /******************************************************************************/
 
 extern bool
@@ -175,7 +175,7 @@ xsg_imlib_blend_mask(Imlib_Image mask)
 	unsigned int image_width, image_height;
 	unsigned int mask_width, mask_height;
 	unsigned int width, height;
-	unsigned int x, y;
+	unsigned int y;
 
 	image = imlib_context_get_image();
 
@@ -193,20 +193,8 @@ xsg_imlib_blend_mask(Imlib_Image mask)
 	height = MIN(mask_height, image_height);
 
 	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			unsigned char *img;
-			unsigned char *msk;
-
-			img = (unsigned char *) (image_data
-					+ x + y * image_width);
-			msk = (unsigned char *) (mask_data
-					+ x + y * mask_width);
-
-			img[0] = (img[0] * msk[0]) / 0xff;
-			img[1] = (img[1] * msk[1]) / 0xff;
-			img[2] = (img[2] * msk[2]) / 0xff;
-			img[3] = (img[3] * msk[3]) / 0xff;
-		}
+		xsg_argb_mul(image_data + y * image_width,
+				mask_data + y * mask_width, width);
 	}
 
 	imlib_image_put_back_data(image_data);
@@ -81,6 +81,25 @@ typedef struct _xsg_var_t xsg_var_t;
 
 /******************************************************************************/
 
+/* keyword table for xsg_conf_find_keyword: the perfect hash over names is
+ * built on first use, ids are indices into names */
+typedef struct _xsg_conf_keywords_t {
+	const char * const *names;
+	unsigned count;
+	unsigned mask;
+	unsigned *disp;
+	int *slots;
+} xsg_conf_keywords_t;
+
+#define XSG_CONF_KEYWORDS(names) \
+	{ (names), sizeof(names) / sizeof((names)[0]), 0, NULL, NULL }
+
+/******************************************************************************/
+
+/* strings returned by the str getters are borrowed, not copied: they must
+ * stay valid until the next update, also when the getter is called with
+ * another arg in between, so each arg needs its own buffer */
+
 typedef struct _xsg_module_t {
 	void (*parse)(
 		uint64_t update,
@@ -127,6 +146,9 @@ xsg_conf_read_string(void);
 extern XSG_API bool
 xsg_conf_find_command(const char *command);
 
+extern XSG_API int
+xsg_conf_find_keyword(xsg_conf_keywords_t *keywords);
+
 extern XSG_API XSG_PRINTF(1, 2) void
 xsg_conf_error(const char *format, ...);
 
@@ -140,6 +162,32 @@ xsg_conf_warning(const char *format, ...);
 extern XSG_API void
 xsg_var_dirty(xsg_var_t *var);
 
+/******************************************************************************
+ * rpn.c
+ ******************************************************************************/
+
+/* call in parse for getters whose value only changes in update functions,
+ * they are sampled once and shared by all expressions using them */
+
+extern XSG_API void
+xsg_rpn_set_pure(double (*num)(void *), const char *(*str)(void *), void *arg);
+
+/* same for getters whose value never changes after the init functions ran,
+ * expressions using only them are computed once */
+
+extern XSG_API void
+xsg_rpn_set_static(double (*num)(void *), const char *(*str)(void *), void *arg);
+
+/* call in parse to make the number getter num with arg a vector in RPN
+ * expressions, vec returns all values and their number in len */
+
+extern XSG_API void
+xsg_rpn_set_vector(
+	double (*num)(void *),
+	void *arg,
+	const double *(*vec)(void *, unsigned *)
+);
+
 /******************************************************************************
  * main.c
  ******************************************************************************/
@@ -150,6 +198,37 @@ xsg_main_get_interval(void);
 extern XSG_API uint64_t
 xsg_main_get_tick(void);
 
+/* measured delay between the scheduled and the actual start of a tick in
+ * microseconds: last tick, maximum and average */
+
+extern XSG_API uint64_t
+xsg_main_get_tick_jitter(void);
+
+extern XSG_API uint64_t
+xsg_main_get_tick_jitter_max(void);
+
+extern XSG_API uint64_t
+xsg_main_get_tick_jitter_avg(void);
+
+/* time spent in a tick until the main loop went to sleep in microseconds
+ * (last tick, maximum and average), number of ticks that took longer than the
+ * interval and number of missed ticks */
+
+extern XSG_API uint64_t
+xsg_main_get_tick_work(void);
+
+extern XSG_API uint64_t
+xsg_main_get_tick_work_max(void);
+
+extern XSG_API uint64_t
+xsg_main_get_tick_work_avg(void);
+
+extern XSG_API uint64_t
+xsg_main_get_tick_overruns(void);
+
+extern XSG_API uint64_t
+xsg_main_get_tick_missed(void);
+
 extern XSG_API void
 xsg_main_add_init_func(void (*func)(void));
 
@@ -162,6 +241,10 @@ xsg_main_add_update_func(void (*func)(uint64_t tick));
 extern XSG_API void
 xsg_main_add_signal_handler(void (*func)(int signum), int signum);
 
+/* call in forked child processes before exec */
+extern XSG_API void
+xsg_main_reset_signal_mask(void);
+
 typedef struct _xsg_main_timeout_t {
 	struct timeval tv; /* absolute time */
 	void (*func)(void *arg, bool time_error);
@@ -193,6 +276,26 @@ xsg_main_add_poll(xsg_main_poll_t *poll);
 extern XSG_API void
 xsg_main_remove_poll(xsg_main_poll_t *poll);
 
+/******************************************************************************
+ * worker.c
+ ******************************************************************************/
+
+/* sample runs in a worker thread and must not call any xsg_* function,
+ * publish runs in the main thread at the beginning of the next tick.
+ * Without worker threads both run immediately in xsg_worker_submit. */
+
+typedef struct _xsg_worker_job_t {
+	void (*sample)(void *arg);
+	void (*publish)(void *arg);
+	void *arg;
+} xsg_worker_job_t;
+
+extern XSG_API void
+xsg_worker_submit(xsg_worker_job_t *job);
+
+extern XSG_API bool
+xsg_worker_enabled(void);
+
 /******************************************************************************
  * list.c
  ******************************************************************************/
@@ -208,6 +311,9 @@ struct _xsg_list_t {
 extern XSG_API xsg_list_t *
 xsg_list_append(xsg_list_t *list, void *data);
 
+extern XSG_API xsg_list_t *
+xsg_list_append_last(xsg_list_t *list, xsg_list_t **last, void *data);
+
 extern XSG_API xsg_list_t *
 xsg_list_prepend(xsg_list_t *list, void *data);
 
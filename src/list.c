@@ -111,6 +111,33 @@ xsg_list_append(xsg_list_t *list, void *data)
 	}
 }
 
+/* like xsg_list_append, but *last remembers the last element between calls,
+ * so building a list element by element is linear instead of quadratic;
+ * *last may be NULL or lag behind, the rest of the list is walked then */
+xsg_list_t *
+xsg_list_append_last(xsg_list_t *list, xsg_list_t **last, void *data)
+{
+	xsg_list_t *new_list;
+	xsg_list_t *tail;
+
+	new_list = xsg_new(xsg_list_t, 1);
+	new_list->data = data;
+	new_list->next = NULL;
+
+	if (list) {
+		tail = xsg_list_last(*last ? *last : list);
+		tail->next = new_list;
+		new_list->prev = tail;
+	} else {
+		new_list->prev = NULL;
+		list = new_list;
+	}
+
+	*last = new_list;
+
+	return list;
+}
+
 xsg_list_t *
 xsg_list_prepend(xsg_list_t *list, void *data)
 {
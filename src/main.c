@@ -23,10 +23,18 @@
 #include <time.h>
 #include <signal.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#ifdef Linux
+# include <sys/epoll.h>
+# include <sys/timerfd.h>
+# include <sys/signalfd.h>
+#endif
 
 #include "main.h"
 #include "var.h"
+#include "worker.h"
+#include "profile.h"
 
 /******************************************************************************/
 
@@ -50,14 +58,56 @@ static flist_t *handler_sigusr2_list = NULL;
 static flist_t *handler_sighup_list = NULL;
 
 static xsg_list_t *poll_list = NULL;
-static xsg_list_t *timeout_list = NULL;
-
 static xsg_list_t *poll_remove_list = NULL;
-static xsg_list_t *timeout_remove_list = NULL;
+
+/* binary min-heap ordered by tv, the heap index (plus one) of each timeout
+ * is kept in timeout_heap_index, xsg_main_timeout_t is part of the module
+ * interface */
+static xsg_main_timeout_t **timeout_heap = NULL;
+static size_t timeout_heap_len = 0;
+static size_t timeout_heap_size = 0;
+static xsg_hash_table_t *timeout_heap_index = NULL;
+
+/* expired timeouts while their functions are running */
+typedef struct _fired_timeout_t {
+	xsg_main_timeout_t *timeout;
+	bool keep;
+} fired_timeout_t;
+
+static fired_timeout_t *fired_timeouts = NULL;
+static size_t fired_timeouts_len = 0;
+static size_t fired_timeouts_size = 0;
 
 static uint64_t tick = 0;
+static uint64_t update_count = 0;
 static uint64_t interval = 1000;
 
+/* monotonic time of the next tick in microseconds */
+static uint64_t tick_deadline = 0;
+
+/* wall clock minus monotonic time, used to detect clock steps */
+static int64_t wall_offset = 0;
+
+/* how late the ticks started in microseconds */
+static uint64_t tick_jitter = 0;
+static uint64_t tick_jitter_max = 0;
+static uint64_t tick_jitter_sum = 0;
+static uint64_t tick_jitter_count = 0;
+
+/* time spent in a tick until the main loop goes to sleep in microseconds,
+ * ticks whose work took longer than the interval and missed ticks */
+static uint64_t tick_start = 0;
+static uint64_t tick_work = 0;
+static uint64_t tick_work_max = 0;
+static uint64_t tick_work_sum = 0;
+static uint64_t tick_work_count = 0;
+static uint64_t tick_overruns = 0;
+static uint64_t tick_missed = 0;
+
+/* missed ticks are coalesced into the next one or skipped */
+static bool skip_missed_ticks = FALSE;
+static uint64_t tick_skip = 0;
+
 static bool received_sigalrm = FALSE;
 static bool received_sigchld = FALSE;
 static bool received_sigpipe = FALSE;
@@ -67,6 +117,19 @@ static bool received_sighup = FALSE;
 
 static bool time_error = FALSE;
 
+/* user signals blocked for the signalfd */
+static sigset_t user_signals_blocked;
+static bool user_signals_blocked_valid = FALSE;
+
+/******************************************************************************/
+
+#ifdef Linux
+# define EPOLL_MAX_EVENTS 64
+
+static int epoll_fd = -1;
+static bool epoll_failed = FALSE;
+#endif
+
 /******************************************************************************/
 
 void
@@ -90,6 +153,15 @@ xsg_main_get_tick(void)
 	return tick;
 }
 
+/* incremented whenever update functions or worker jobs may have changed
+ * module data, values read in between stay the same */
+
+uint64_t
+xsg_main_get_update_count(void)
+{
+	return update_count;
+}
+
 /******************************************************************************/
 
 static flist_t *
@@ -140,6 +212,137 @@ xsg_main_add_update_func(void (*func)(uint64_t))
 
 /******************************************************************************/
 
+#ifdef Linux
+
+/* The epoll backend registers file descriptors incrementally when they are
+ * added or removed and only dispatches the ready ones. If epoll is not
+ * available or refuses a file descriptor (e.g. a regular file), we fall back
+ * to select for the rest of the program's lifetime. */
+
+static void
+epoll_disable(void)
+{
+	if (epoll_fd >= 0) {
+		close(epoll_fd);
+	}
+
+	epoll_fd = -1;
+	epoll_failed = TRUE;
+
+	xsg_message("using select backend");
+}
+
+static bool
+epoll_init(void)
+{
+	if (epoll_fd >= 0) {
+		return TRUE;
+	}
+
+	if (epoll_failed) {
+		return FALSE;
+	}
+
+	epoll_fd = epoll_create(EPOLL_MAX_EVENTS);
+
+	if (unlikely(epoll_fd < 0)) {
+		xsg_warning("epoll_create failed: %s", strerror(errno));
+		epoll_disable();
+		return FALSE;
+	}
+
+	xsg_set_cloexec_flag(epoll_fd, TRUE);
+
+	xsg_message("using epoll backend");
+
+	return TRUE;
+}
+
+/* another active poll on the same fd */
+static xsg_main_poll_t *
+epoll_find_fd(xsg_main_poll_t *poll)
+{
+	xsg_list_t *l;
+
+	for (l = poll_list; l; l = l->next) {
+		xsg_main_poll_t *p = l->data;
+
+		if (p != poll && p->fd == poll->fd
+				&& !xsg_list_find(poll_remove_list, p)) {
+			return p;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+epoll_register(xsg_main_poll_t *poll)
+{
+	struct epoll_event event;
+
+	if (unlikely(poll->fd < 0)) {
+		xsg_warning("invalid poll fd: %d", poll->fd);
+		return;
+	}
+
+	event.events = 0;
+	event.data.ptr = poll;
+
+	if (poll->events & XSG_MAIN_POLL_READ) {
+		event.events |= EPOLLIN;
+	}
+	if (poll->events & XSG_MAIN_POLL_WRITE) {
+		event.events |= EPOLLOUT;
+	}
+	if (poll->events & XSG_MAIN_POLL_EXCEPT) {
+		event.events |= EPOLLPRI;
+	}
+
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, poll->fd, &event) == 0) {
+		return;
+	}
+
+	if (errno == EEXIST) {
+		/* NOTE: epoll keeps only one entry per fd, select dispatches
+		 * every poll waiting on it */
+		if (epoll_find_fd(poll) != NULL) {
+			xsg_message("fd %d is polled more than once", poll->fd);
+			epoll_disable();
+			return;
+		}
+
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, poll->fd, &event) == 0) {
+			return;
+		}
+	}
+
+	xsg_warning("epoll_ctl for fd %d failed: %s", poll->fd,
+			strerror(errno));
+	epoll_disable();
+}
+
+static void
+epoll_unregister(xsg_main_poll_t *poll)
+{
+	struct epoll_event event;
+
+	if (poll->fd < 0) {
+		return;
+	}
+
+	/* the fd may have been closed and reused by another poll */
+	if (epoll_find_fd(poll) != NULL) {
+		return;
+	}
+
+	/* NOTE: the fd may already be closed, which removes it from the
+	 * epoll set anyway, so errors are expected here. */
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, poll->fd, &event);
+}
+
+#endif /* Linux */
+
 void
 xsg_main_add_poll(xsg_main_poll_t *poll)
 {
@@ -149,19 +352,33 @@ xsg_main_add_poll(xsg_main_poll_t *poll)
 
 	poll_remove_list = xsg_list_remove(poll_remove_list, poll);
 
-	if (xsg_list_find(poll_list, poll)) {
-		return;
+	if (!xsg_list_find(poll_list, poll)) {
+		poll_list = xsg_list_prepend(poll_list, poll);
 	}
 
-	poll_list = xsg_list_prepend(poll_list, poll);
+#ifdef Linux
+	/* NOTE: (re-)register even if the poll is already known, because
+	 * its fd or events may have changed in the meantime */
+	if (epoll_init()) {
+		epoll_register(poll);
+	}
+#endif
 }
 
 void
 xsg_main_remove_poll(xsg_main_poll_t *poll)
 {
-	if (likely(poll != NULL)) {
-		poll_remove_list = xsg_list_prepend(poll_remove_list, poll);
+	if (unlikely(poll == NULL)) {
+		return;
 	}
+
+	poll_remove_list = xsg_list_prepend(poll_remove_list, poll);
+
+#ifdef Linux
+	if (epoll_fd >= 0) {
+		epoll_unregister(poll);
+	}
+#endif
 }
 
 static void
@@ -177,43 +394,407 @@ remove_polls(void)
 	poll_remove_list = NULL;
 }
 
+static void
+dispatch_poll(xsg_main_poll_t *p, xsg_main_poll_events_t events)
+{
+	if (xsg_list_find(poll_remove_list, p)) {
+		return;
+	}
+
+	if (unlikely(p->fd < 0)) {
+		xsg_warning("invalid poll fd: %d", p->fd);
+		return;
+	}
+
+	events &= p->events;
+
+	if (!events) {
+		return;
+	}
+
+	if (unlikely(xsg_profile_enabled)) {
+		uint64_t start = xsg_profile_start();
+
+		(p->func)(p->arg, events);
+		xsg_profile_stop(xsg_profile_find("poll", (void *) p->func),
+				start);
+	} else {
+		(p->func)(p->arg, events);
+	}
+}
+
+/******************************************************************************/
+
+static int
+poll_select(struct timeval *timeout)
+{
+	fd_set read_fds;
+	fd_set write_fds;
+	fd_set except_fds;
+	int fd_count, fd_max;
+	xsg_list_t *l;
+
+	fd_max = 0;
+	FD_ZERO(&read_fds);
+	FD_ZERO(&write_fds);
+	FD_ZERO(&except_fds);
+
+	for (l = poll_list; l; l = l->next) {
+		xsg_main_poll_t *p = l->data;
+
+		if (unlikely(p->fd < 0)) {
+			xsg_warning("invalid poll fd: %d", p->fd);
+			continue;
+		}
+
+		if (p->events & XSG_MAIN_POLL_READ) {
+			FD_SET(p->fd, &read_fds);
+			fd_max = MAX(fd_max, p->fd);
+		}
+		if (p->events & XSG_MAIN_POLL_WRITE) {
+			FD_SET(p->fd, &write_fds);
+			fd_max = MAX(fd_max, p->fd);
+		}
+		if (p->events & XSG_MAIN_POLL_EXCEPT) {
+			FD_SET(p->fd, &except_fds);
+			fd_max = MAX(fd_max, p->fd);
+		}
+	}
+
+	fd_count = select(fd_max + 1, &read_fds, &write_fds, &except_fds,
+			timeout);
+
+	if (fd_count <= 0) {
+		return fd_count;
+	}
+
+	xsg_debug("select: interrupted by file descriptor");
+
+	for (l = poll_list; l; l = l->next) {
+		xsg_main_poll_events_t events = 0;
+		xsg_main_poll_t *p = l->data;
+
+		if (unlikely(p->fd < 0)) {
+			continue;
+		}
+
+		if (FD_ISSET(p->fd, &read_fds)) {
+			events |= XSG_MAIN_POLL_READ;
+		}
+		if (FD_ISSET(p->fd, &write_fds)) {
+			events |= XSG_MAIN_POLL_WRITE;
+		}
+		if (FD_ISSET(p->fd, &except_fds)) {
+			events |= XSG_MAIN_POLL_EXCEPT;
+		}
+		if (events) {
+			dispatch_poll(p, events);
+		}
+	}
+
+	return fd_count;
+}
+
+#ifdef Linux
+static int
+poll_epoll(struct timeval *timeout)
+{
+	struct epoll_event events[EPOLL_MAX_EVENTS];
+	int fd_count, i;
+	uint64_t msec;
+
+	if (timeout != NULL) {
+		/* round up, epoll_wait has only millisecond resolution */
+		msec = (uint64_t) timeout->tv_sec * 1000
+			+ ((uint64_t) timeout->tv_usec + 999) / 1000;
+		msec = MIN(msec, (uint64_t) INT32_MAX);
+	} else {
+		msec = -1;
+	}
+
+	fd_count = epoll_wait(epoll_fd, events, EPOLL_MAX_EVENTS, (int) msec);
+
+	if (fd_count <= 0) {
+		return fd_count;
+	}
+
+	xsg_debug("epoll_wait: interrupted by file descriptor");
+
+	for (i = 0; i < fd_count; i++) {
+		xsg_main_poll_t *p = events[i].data.ptr;
+		xsg_main_poll_events_t e = 0;
+		uint32_t ev = events[i].events;
+
+		/* removed by a poll dispatched before */
+		if (xsg_list_find(poll_remove_list, p)) {
+			continue;
+		}
+
+		if (ev & EPOLLIN) {
+			e |= XSG_MAIN_POLL_READ;
+		}
+		if (ev & EPOLLOUT) {
+			e |= XSG_MAIN_POLL_WRITE;
+		}
+		if (ev & EPOLLPRI) {
+			e |= XSG_MAIN_POLL_EXCEPT;
+		}
+
+		/* NOTE: hangups and errors are reported for every fd and,
+		 * being level triggered, again and again. Pass them to
+		 * whatever the poll waits for, like select does, and stop
+		 * watching the fd if it waits for nothing. */
+		if (ev & (EPOLLHUP | EPOLLERR)) {
+			e |= p->events;
+
+			if (!(p->events & (XSG_MAIN_POLL_READ
+					| XSG_MAIN_POLL_WRITE
+					| XSG_MAIN_POLL_EXCEPT))) {
+				epoll_unregister(p);
+				continue;
+			}
+		}
+
+		dispatch_poll(p, e);
+	}
+
+	return fd_count;
+}
+#endif /* Linux */
+
+static int
+poll_wait(struct timeval *timeout)
+{
+#ifdef Linux
+	if (epoll_init()) {
+		return poll_epoll(timeout);
+	}
+#endif
+	return poll_select(timeout);
+}
+
 /******************************************************************************/
 
+static size_t
+timeout_index(xsg_main_timeout_t *t)
+{
+	return (size_t) xsg_hash_table_lookup(timeout_heap_index, t) - 1;
+}
+
+static bool
+timeout_in_heap(xsg_main_timeout_t *t)
+{
+	if (timeout_heap_index == NULL) {
+		return FALSE;
+	}
+
+	return xsg_hash_table_lookup(timeout_heap_index, t) != NULL;
+}
+
+static void
+timeout_heap_set(size_t index, xsg_main_timeout_t *t)
+{
+	timeout_heap[index] = t;
+	xsg_hash_table_insert(timeout_heap_index, t, (void *) (index + 1));
+}
+
+static void
+timeout_heap_sift_up(size_t index)
+{
+	xsg_main_timeout_t *t = timeout_heap[index];
+
+	while (index > 0) {
+		size_t parent = (index - 1) / 2;
+
+		if (!xsg_timercmp(&t->tv, &timeout_heap[parent]->tv, <)) {
+			break;
+		}
+
+		timeout_heap_set(index, timeout_heap[parent]);
+		index = parent;
+	}
+
+	timeout_heap_set(index, t);
+}
+
+static void
+timeout_heap_sift_down(size_t index)
+{
+	xsg_main_timeout_t *t = timeout_heap[index];
+
+	while (1) {
+		size_t child = 2 * index + 1;
+
+		if (child >= timeout_heap_len) {
+			break;
+		}
+
+		if ((child + 1 < timeout_heap_len)
+		 && xsg_timercmp(&timeout_heap[child + 1]->tv,
+				 &timeout_heap[child]->tv, <)) {
+			child++;
+		}
+
+		if (!xsg_timercmp(&timeout_heap[child]->tv, &t->tv, <)) {
+			break;
+		}
+
+		timeout_heap_set(index, timeout_heap[child]);
+		index = child;
+	}
+
+	timeout_heap_set(index, t);
+}
+
+static void
+timeout_heap_push(xsg_main_timeout_t *t)
+{
+	if (timeout_heap_index == NULL) {
+		timeout_heap_index = xsg_hash_table_new(xsg_direct_hash,
+				xsg_direct_equal);
+	}
+
+	if (timeout_heap_len == timeout_heap_size) {
+		timeout_heap_size = MAX(16, timeout_heap_size * 2);
+		timeout_heap = xsg_renew(xsg_main_timeout_t *, timeout_heap,
+				timeout_heap_size);
+	}
+
+	timeout_heap_set(timeout_heap_len, t);
+	timeout_heap_len++;
+	timeout_heap_sift_up(timeout_heap_len - 1);
+}
+
+static void
+timeout_heap_remove(xsg_main_timeout_t *t)
+{
+	size_t index = timeout_index(t);
+
+	xsg_hash_table_remove(timeout_heap_index, t);
+
+	timeout_heap_len--;
+
+	if (index != timeout_heap_len) {
+		xsg_main_timeout_t *last = timeout_heap[timeout_heap_len];
+
+		timeout_heap_set(index, last);
+		timeout_heap_sift_up(index);
+		timeout_heap_sift_down(timeout_index(last));
+	}
+}
+
+static fired_timeout_t *
+find_fired_timeout(xsg_main_timeout_t *t)
+{
+	size_t i;
+
+	for (i = 0; i < fired_timeouts_len; i++) {
+		if (fired_timeouts[i].timeout == t) {
+			return fired_timeouts + i;
+		}
+	}
+
+	return NULL;
+}
+
 void
 xsg_main_add_timeout(xsg_main_timeout_t *timeout)
 {
+	fired_timeout_t *fired;
+
 	if (unlikely(timeout == NULL)) {
 		return;
 	}
 
-	timeout_remove_list = xsg_list_remove(timeout_remove_list, timeout);
+	if (timeout_in_heap(timeout)) {
+		/* tv may have changed */
+		timeout_heap_sift_up(timeout_index(timeout));
+		timeout_heap_sift_down(timeout_index(timeout));
+		return;
+	}
 
-	if (xsg_list_find(timeout_list, timeout)) {
+	fired = find_fired_timeout(timeout);
+
+	if (fired != NULL) {
+		fired->keep = TRUE;
 		return;
 	}
 
-	timeout_list = xsg_list_prepend(timeout_list, timeout);
+	timeout_heap_push(timeout);
 }
 
 void
 xsg_main_remove_timeout(xsg_main_timeout_t *timeout)
 {
-	if (likely(timeout != NULL)) {
-		timeout_remove_list = xsg_list_prepend(timeout_remove_list, timeout);
+	fired_timeout_t *fired;
+
+	if (unlikely(timeout == NULL)) {
+		return;
+	}
+
+	if (timeout_in_heap(timeout)) {
+		timeout_heap_remove(timeout);
+		return;
+	}
+
+	fired = find_fired_timeout(timeout);
+
+	if (fired != NULL) {
+		fired->keep = FALSE;
 	}
 }
 
+/* Run the functions of all timeouts expired before now (or all timeouts if
+ * time_error is set). Like before, a timeout stays registered until it is
+ * removed, so timeouts not removed by their function are pushed back. */
 static void
-remove_timeouts(void)
+run_timeouts(struct timeval *now, bool time_error)
 {
-	xsg_list_t *l;
+	size_t i;
+
+	while (timeout_heap_len > 0) {
+		xsg_main_timeout_t *t = timeout_heap[0];
+
+		if (!time_error && !xsg_timercmp(&t->tv, now, <)) {
+			break;
+		}
+
+		timeout_heap_remove(t);
+
+		if (fired_timeouts_len == fired_timeouts_size) {
+			fired_timeouts_size = MAX(16, fired_timeouts_size * 2);
+			fired_timeouts = xsg_renew(fired_timeout_t,
+					fired_timeouts, fired_timeouts_size);
+		}
+
+		fired_timeouts[fired_timeouts_len].timeout = t;
+		fired_timeouts[fired_timeouts_len].keep = TRUE;
+		fired_timeouts_len++;
+	}
+
+	for (i = 0; i < fired_timeouts_len; i++) {
+		xsg_main_timeout_t *t = fired_timeouts[i].timeout;
+
+		if (fired_timeouts[i].keep) {
+			if (unlikely(xsg_profile_enabled)) {
+				uint64_t start = xsg_profile_start();
+
+				t->func(t->arg, time_error);
+				xsg_profile_stop(xsg_profile_find("timeout",
+						(void *) t->func), start);
+			} else {
+				t->func(t->arg, time_error);
+			}
+		}
+	}
 
-	for (l = timeout_remove_list; l; l = l->next) {
-		timeout_list = xsg_list_remove(timeout_list, l->data);
+	for (i = 0; i < fired_timeouts_len; i++) {
+		if (fired_timeouts[i].keep) {
+			timeout_heap_push(fired_timeouts[i].timeout);
+		}
 	}
 
-	xsg_list_free(timeout_remove_list);
-	timeout_remove_list = NULL;
+	fired_timeouts_len = 0;
 }
 
 /******************************************************************************/
@@ -285,6 +866,166 @@ run_signal_handler(flist_t *list, int signum)
 	}
 }
 
+static void
+run_received_signal_handlers(void)
+{
+	if (unlikely(received_sigalrm)) {
+		received_sigalrm = FALSE;
+		run_signal_handler(handler_sigalrm_list, SIGALRM);
+	}
+	if (unlikely(received_sigchld)) {
+		received_sigchld = FALSE;
+		run_signal_handler(handler_sigchld_list, SIGCHLD);
+	}
+	if (unlikely(received_sigpipe)) {
+		received_sigpipe = FALSE;
+		run_signal_handler(handler_sigpipe_list, SIGPIPE);
+	}
+	if (unlikely(received_sigusr1)) {
+		received_sigusr1 = FALSE;
+		run_signal_handler(handler_sigusr1_list, SIGUSR1);
+	}
+	if (unlikely(received_sigusr2)) {
+		received_sigusr2 = FALSE;
+		run_signal_handler(handler_sigusr2_list, SIGUSR2);
+	}
+	if (unlikely(received_sighup)) {
+		received_sighup = FALSE;
+		run_signal_handler(handler_sighup_list, SIGHUP);
+	}
+}
+
+static void
+set_received_signal(int signum)
+{
+	switch (signum) {
+	case SIGALRM: received_sigalrm = TRUE; return;
+	case SIGCHLD: received_sigchld = TRUE; return;
+	case SIGPIPE: received_sigpipe = TRUE; return;
+	case SIGUSR1: received_sigusr1 = TRUE; return;
+	case SIGUSR2: received_sigusr2 = TRUE; return;
+	case SIGHUP: received_sighup = TRUE; return;
+	default: return;
+	}
+}
+
+/******************************************************************************/
+
+#ifdef Linux
+
+/* The user signals are blocked and read from a signalfd, so they are
+ * ordinary poll events: no EINTR, and all signals that arrived while
+ * sleeping are handled with one wakeup, each signal number only once. */
+
+static void
+read_signalfd(void *arg, xsg_main_poll_events_t events);
+
+static xsg_main_poll_t signal_poll = {
+	-1,
+	XSG_MAIN_POLL_READ,
+	read_signalfd,
+	NULL
+};
+
+static void
+read_signalfd(void *arg, xsg_main_poll_events_t events)
+{
+	struct signalfd_siginfo info[16];
+	ssize_t n;
+
+	while (1) {
+		size_t i;
+
+		n = read(signal_poll.fd, info, sizeof(info));
+
+		if (n <= 0) {
+			break;
+		}
+
+		for (i = 0; i < n / sizeof(struct signalfd_siginfo); i++) {
+			xsg_message("received signal %u: %s",
+					(unsigned) info[i].ssi_signo,
+					signum2str(info[i].ssi_signo));
+			set_received_signal(info[i].ssi_signo);
+		}
+
+		if (n < sizeof(info)) {
+			break;
+		}
+	}
+
+	if (unlikely(n == -1) && errno != EAGAIN && errno != EINTR) {
+		xsg_warning("read from signalfd failed: %s", strerror(errno));
+	}
+
+	run_received_signal_handlers();
+}
+
+static void
+signalfd_init(void)
+{
+	static const int user_signals[] = {
+		SIGALRM, SIGCHLD, SIGPIPE, SIGUSR1, SIGUSR2, SIGHUP
+	};
+	sigset_t set;
+	unsigned i;
+	int fd;
+
+	sigemptyset(&set);
+
+	for (i = 0; i < sizeof(user_signals) / sizeof(user_signals[0]); i++) {
+		sigaddset(&set, user_signals[i]);
+	}
+
+	if (sigprocmask(SIG_BLOCK, &set, NULL) < 0) {
+		xsg_warning("sigprocmask failed: %s", strerror(errno));
+		return;
+	}
+
+	fd = signalfd(-1, &set, 0);
+
+	if (fd < 0) {
+		xsg_warning("signalfd failed: %s", strerror(errno));
+		sigprocmask(SIG_UNBLOCK, &set, NULL);
+		return;
+	}
+
+	xsg_set_cloexec_flag(fd, TRUE);
+
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+		xsg_warning("cannot set O_NONBLOCK for signalfd: %s",
+				strerror(errno));
+	}
+
+	user_signals_blocked = set;
+	user_signals_blocked_valid = TRUE;
+
+	signal_poll.fd = fd;
+
+	xsg_main_add_poll(&signal_poll);
+
+	xsg_message("using signalfd for signal handling");
+}
+
+#else /* Linux */
+
+static void
+signalfd_init(void)
+{
+}
+
+#endif /* Linux */
+
+/* The signal mask survives fork and exec, so children have to unblock the
+ * signals which are read from the signalfd. */
+void
+xsg_main_reset_signal_mask(void)
+{
+	if (user_signals_blocked_valid) {
+		sigprocmask(SIG_UNBLOCK, &user_signals_blocked, NULL);
+	}
+}
+
 /******************************************************************************/
 
 void
@@ -295,43 +1036,281 @@ xsg_main_set_time_error(void)
 
 /******************************************************************************/
 
+uint64_t
+xsg_main_get_tick_jitter(void)
+{
+	return tick_jitter;
+}
+
+uint64_t
+xsg_main_get_tick_jitter_max(void)
+{
+	return tick_jitter_max;
+}
+
+uint64_t
+xsg_main_get_tick_jitter_avg(void)
+{
+	if (tick_jitter_count == 0) {
+		return 0;
+	}
+
+	return tick_jitter_sum / tick_jitter_count;
+}
+
+uint64_t
+xsg_main_get_tick_work(void)
+{
+	return tick_work;
+}
+
+uint64_t
+xsg_main_get_tick_work_max(void)
+{
+	return tick_work_max;
+}
+
+uint64_t
+xsg_main_get_tick_work_avg(void)
+{
+	if (tick_work_count == 0) {
+		return 0;
+	}
+
+	return tick_work_sum / tick_work_count;
+}
+
+uint64_t
+xsg_main_get_tick_overruns(void)
+{
+	return tick_overruns;
+}
+
+uint64_t
+xsg_main_get_tick_missed(void)
+{
+	return tick_missed;
+}
+
+void
+xsg_main_set_skip_missed_ticks(bool skip)
+{
+	xsg_message("%s missed ticks", skip ? "skipping" : "coalescing");
+	skip_missed_ticks = skip;
+}
+
+/******************************************************************************/
+
+static uint64_t
+get_monotonic_time(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if (likely(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)) {
+		return (uint64_t) ts.tv_sec * 1000000
+			+ (uint64_t) ts.tv_nsec / 1000;
+	}
+
+	xsg_error("clock_gettime(CLOCK_MONOTONIC) failed: %s",
+			strerror(errno));
+
+	return 0;
+#else
+	struct timeval tv;
+
+	xsg_gettimeofday(&tv, NULL);
+
+	return (uint64_t) tv.tv_sec * 1000000 + (uint64_t) tv.tv_usec;
+#endif
+}
+
+static uint64_t
+get_wall_time(void)
+{
+	struct timeval tv;
+
+	xsg_gettimeofday(&tv, NULL);
+
+	return (uint64_t) tv.tv_sec * 1000000 + (uint64_t) tv.tv_usec;
+}
+
+/******************************************************************************/
+
+#ifdef Linux
+
+/* The tick timer is a timerfd armed with the absolute monotonic time of the
+ * next tick, so ticks are not limited to the millisecond resolution of
+ * epoll_wait. */
+
+static void
+read_tick_timer(void *arg, xsg_main_poll_events_t events);
+
+static xsg_main_poll_t tick_poll = {
+	-1,
+	XSG_MAIN_POLL_READ,
+	read_tick_timer,
+	NULL
+};
+
+static void
+read_tick_timer(void *arg, xsg_main_poll_events_t events)
+{
+	uint64_t expirations;
+	ssize_t n;
+
+	n = read(tick_poll.fd, &expirations, sizeof(expirations));
+
+	if (unlikely(n == -1) && errno != EAGAIN && errno != EINTR) {
+		xsg_warning("read from timerfd failed: %s", strerror(errno));
+	}
+}
+
 static void
-get_next_update_time(struct timeval *tv)
+tick_timer_init(void)
 {
-	uint64_t msec, msec1, msec2, sec, usec;
-	struct timeval now;
+	int fd;
 
-	if (interval == 0) {
-		xsg_gettimeofday(tv, NULL);
+	fd = timerfd_create(CLOCK_MONOTONIC, 0);
+
+	if (fd < 0) {
+		xsg_warning("timerfd_create failed: %s", strerror(errno));
 		return;
 	}
 
-	xsg_gettimeofday(&now, NULL);
+	xsg_set_cloexec_flag(fd, TRUE);
+
+	tick_poll.fd = fd;
+
+	xsg_main_add_poll(&tick_poll);
+}
+
+static bool
+tick_timer_arm(uint64_t deadline)
+{
+	struct itimerspec its;
+
+	if (tick_poll.fd < 0) {
+		return FALSE;
+	}
+
+	its.it_interval.tv_sec = 0;
+	its.it_interval.tv_nsec = 0;
+	its.it_value.tv_sec = deadline / 1000000;
+	its.it_value.tv_nsec = (deadline % 1000000) * 1000;
+
+	/* NOTE: a zero it_value would disarm the timer */
+	if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) {
+		its.it_value.tv_nsec = 1;
+	}
+
+	if (timerfd_settime(tick_poll.fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+		xsg_warning("timerfd_settime failed: %s", strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+#else /* Linux */
+
+static void
+tick_timer_init(void)
+{
+}
+
+static bool
+tick_timer_arm(uint64_t deadline)
+{
+	return FALSE;
+}
+
+#endif /* Linux */
+
+static bool tick_timer_armed = FALSE;
+
+/* Ticks are scheduled on the monotonic clock, each deadline is the previous
+ * one plus the interval, so there is no drift. The phase is aligned to the
+ * wall clock (e.g. a 1000 ms interval ticks at full seconds) and realigned
+ * when the wall clock is stepped. Missed deadlines are never run late in a
+ * bunch: they are either coalesced into the next tick, which keeps the tick
+ * numbers consecutive, or skipped, which advances the tick numbers by the
+ * number of missed ticks. */
+static void
+schedule_next_tick(void)
+{
+	uint64_t now, wall, interval_usec;
+	int64_t offset;
 
-	/* normalize now */
-	now.tv_usec += 1000 - now.tv_usec % 1000;
+	now = get_monotonic_time();
+	interval_usec = interval * 1000;
 
-	if (now.tv_usec >= 1000000) {
-		now.tv_sec += 1;
-		now.tv_usec -= 1000000;
+	if (interval_usec == 0) {
+		tick_deadline = now;
+		tick_timer_armed = FALSE;
+		return;
 	}
 
-	msec1 = (uint64_t) now.tv_sec * 1000;
-	msec2 = (uint64_t) now.tv_usec / 1000;
-	msec = msec1 + msec2;
+	wall = get_wall_time();
+	offset = (int64_t) (wall - now);
+
+	if ((tick_deadline == 0) || (ABS(offset - wall_offset) > 10000)) {
+		if (tick_deadline != 0) {
+			xsg_message("wall clock stepped by %"PRId64" usec: "
+					"realigning ticks",
+					offset - wall_offset);
+		}
+		tick_deadline = now + interval_usec - wall % interval_usec;
+	} else {
+		tick_deadline += interval_usec;
 
-	msec = msec % interval;
-	msec = interval - msec;
+		if (tick_deadline <= now) {
+			uint64_t missed;
 
-	sec = msec / 1000;
-	usec = (msec % 1000) * 1000;
+			missed = (now - tick_deadline) / interval_usec + 1;
+			tick_deadline += missed * interval_usec;
+			tick_missed += missed;
 
-	tv->tv_sec = now.tv_sec + sec;
-	tv->tv_usec = now.tv_usec + usec;
+			if (skip_missed_ticks) {
+				tick_skip = missed;
+			}
 
-	if (tv->tv_usec >= 1000000) {
-		tv->tv_sec += 1;
-		tv->tv_usec -= 1000000;
+			xsg_debug("missed %"PRIu64" tick(s)", missed);
+		}
+	}
+
+	wall_offset = offset;
+
+	tick_timer_armed = tick_timer_arm(tick_deadline);
+}
+
+static void
+measure_tick_jitter(void)
+{
+	uint64_t now;
+
+	now = get_monotonic_time();
+
+	tick_jitter = (now > tick_deadline) ? now - tick_deadline : 0;
+	tick_jitter_max = MAX(tick_jitter_max, tick_jitter);
+	tick_jitter_sum += tick_jitter;
+	tick_jitter_count += 1;
+
+	xsg_debug("tick jitter: %"PRIu64" usec", tick_jitter);
+}
+
+static void
+measure_tick_work(void)
+{
+	tick_work = get_monotonic_time() - tick_start;
+	tick_work_max = MAX(tick_work_max, tick_work);
+	tick_work_sum += tick_work;
+	tick_work_count += 1;
+
+	if (interval != 0 && tick_work > interval * 1000) {
+		tick_overruns += 1;
+		xsg_debug("tick %"PRIu64" overrun: work took %"PRIu64" usec",
+				tick, tick_work);
 	}
 }
 
@@ -340,202 +1319,132 @@ loop(uint64_t num)
 {
 	xsg_message("starting main loop");
 
+	tick_timer_init();
+
 	while (1) {
-		struct timeval time_next_update = { 0, 0 };
+		bool work_measured = FALSE;
 		flist_t *fl;
 
-		if (num != 0 && tick == num) {
+		if (num != 0 && tick >= num) {
 			return;
 		}
 
-		get_next_update_time(&time_next_update);
+		tick_start = get_monotonic_time();
+
+		if (tick_deadline != 0 && interval != 0) {
+			measure_tick_jitter();
+		}
+
+		schedule_next_tick();
 
 		xsg_debug("tick %"PRIu64, tick);
 
+		xsg_worker_publish();
+		update_count++;
+
 		for (fl = update_list; fl; fl = fl->next) {
 			void (*func)(uint64_t) = (void (*)(uint64_t)) fl->func;
-			func(tick);
+
+			if (unlikely(xsg_profile_enabled)) {
+				uint64_t start = xsg_profile_start();
+
+				func(tick);
+				xsg_profile_stop(xsg_profile_find("update",
+						(void *) func), start);
+			} else {
+				func(tick);
+			}
+			update_count++;
 		}
 
 		while (1) {
 			struct timeval time_sleep;
-			struct timeval time_next;
 			struct timeval time_now;
-			fd_set read_fds;
-			fd_set write_fds;
-			fd_set except_fds;
-			int fd_count, fd_max;
-			xsg_list_t *l;
-			bool time_next_is_update;
+			struct timeval *timeout;
+			uint64_t now, sleep;
+			int fd_count;
 
 			if (unlikely(time_error)) {
 				xsg_warning("running all timeout functions due "
 						"to time error");
-				for (l = timeout_list; l; l = l->next) {
-					xsg_main_timeout_t *t = l->data;
-					t->func(t->arg, TRUE);
-				}
-				remove_timeouts();
+				run_timeouts(NULL, TRUE);
 				time_error = FALSE;
 			}
 
-			if (unlikely(received_sigalrm)) {
-				run_signal_handler(handler_sigalrm_list, SIGALRM);
-				received_sigalrm = FALSE;
-			}
-			if (unlikely(received_sigchld)) {
-				run_signal_handler(handler_sigchld_list, SIGCHLD);
-				received_sigchld = FALSE;
-			}
-			if (unlikely(received_sigpipe)) {
-				run_signal_handler(handler_sigpipe_list, SIGPIPE);
-				received_sigpipe = FALSE;
-			}
-			if (unlikely(received_sigusr1)) {
-				run_signal_handler(handler_sigusr1_list, SIGUSR1);
-				received_sigusr1 = FALSE;
-			}
-			if (unlikely(received_sigusr2)) {
-				run_signal_handler(handler_sigusr2_list, SIGUSR2);
-				received_sigusr2 = FALSE;
-			}
-			if (unlikely(received_sighup)) {
-				run_signal_handler(handler_sighup_list, SIGHUP);
-				received_sighup = FALSE;
-			}
+			run_received_signal_handlers();
 
 			xsg_gettimeofday(&time_now, 0);
 
-			time_next.tv_sec = time_next_update.tv_sec;
-			time_next.tv_usec = time_next_update.tv_usec;
-
-			time_next_is_update = TRUE;
-
-			for (l = timeout_list; l; l = l->next) {
-				xsg_main_timeout_t *t = l->data;
-
-				if (xsg_list_find(timeout_remove_list, t)) {
-					continue;
-				}
+			run_timeouts(&time_now, FALSE);
 
-				if (xsg_timercmp(&t->tv, &time_now, <)) {
-					t->func(t->arg, FALSE);
-				}
-			}
+			xsg_var_flush_dirty();
 
-			remove_timeouts();
+			remove_polls();
 
-			for (l = timeout_list; l; l = l->next) {
-				xsg_main_timeout_t *t = l->data;
+			/* the tick timer wakes us up, otherwise we have to
+			 * sleep until the next tick */
+			now = get_monotonic_time();
 
-				if (xsg_timercmp(&t->tv, &time_next, <)) {
-					time_next.tv_sec = t->tv.tv_sec;
-					time_next.tv_usec = t->tv.tv_usec;
-					time_next_is_update = FALSE;
-				}
+			if (tick_timer_armed) {
+				sleep = UINT64_MAX;
+			} else if (tick_deadline > now) {
+				sleep = tick_deadline - now;
+			} else {
+				sleep = 0;
 			}
 
-			xsg_var_flush_dirty();
-
-			fd_max = 0;
-			FD_ZERO(&read_fds);
-			FD_ZERO(&write_fds);
-			FD_ZERO(&except_fds);
-
-			remove_polls();
-			for (l = poll_list; l; l = l->next) {
-				xsg_main_poll_t *p = l->data;
+			if (timeout_heap_len > 0) {
+				xsg_main_timeout_t *t = timeout_heap[0];
 
-				if (unlikely(p->fd < 0)) {
-					xsg_warning("invalid poll fd: %d",
-							p->fd);
-					continue;
-				}
+				xsg_gettimeofday(&time_now, 0);
 
-				if (p->events & XSG_MAIN_POLL_READ) {
-					FD_SET(p->fd, &read_fds);
-					fd_max = MAX(fd_max, p->fd);
-				}
-				if (p->events & XSG_MAIN_POLL_WRITE) {
-					FD_SET(p->fd, &write_fds);
-					fd_max = MAX(fd_max, p->fd);
-				}
-				if (p->events & XSG_MAIN_POLL_EXCEPT) {
-					FD_SET(p->fd, &except_fds);
-					fd_max = MAX(fd_max, p->fd);
+				if (xsg_timercmp(&t->tv, &time_now, <)) {
+					sleep = 0;
+				} else {
+					struct timeval tv;
+
+					xsg_timersub(&t->tv, &time_now, &tv);
+					sleep = MIN(sleep,
+						(uint64_t) tv.tv_sec * 1000000
+						+ (uint64_t) tv.tv_usec);
 				}
 			}
 
-			xsg_gettimeofday(&time_now, 0);
-
-			if (xsg_timercmp(&time_next, &time_now, <)) {
-				xsg_timerclear(&time_sleep);
+			if (sleep == UINT64_MAX) {
+				xsg_debug("sleeping until next tick");
+				timeout = NULL;
 			} else {
-				xsg_timersub(&time_next, &time_now, &time_sleep);
-			}
-
-			/* just to be sure... 100 Hz */
-			time_sleep.tv_usec += 10000;
+				time_sleep.tv_sec = sleep / 1000000;
+				time_sleep.tv_usec = sleep % 1000000;
+				timeout = &time_sleep;
 
-			if (time_sleep.tv_usec >= 1000000) {
-				time_sleep.tv_sec += 1;
-				time_sleep.tv_usec -= 1000000;
+				xsg_debug("sleeping for %u.%06us",
+						(unsigned) time_sleep.tv_sec,
+						(unsigned) time_sleep.tv_usec);
 			}
 
-			xsg_debug("sleeping for %u.%06us",
-					(unsigned) time_sleep.tv_sec,
-					(unsigned) time_sleep.tv_usec);
+			if (!work_measured) {
+				measure_tick_work();
+				work_measured = TRUE;
+			}
 
-			fd_count = select(fd_max + 1, &read_fds, &write_fds,
-					&except_fds, &time_sleep);
+			fd_count = poll_wait(timeout);
 
 			if (unlikely(fd_count == -1) && (errno == EINTR)) {
-				xsg_debug("select: interrupted by signal");
+				xsg_debug("poll: interrupted by signal");
 				continue;
 			}
 
 			if (unlikely(fd_count == -1)) {
-				xsg_error("select: %s", strerror(errno));
+				xsg_error("poll: %s", strerror(errno));
 			}
 
-			if (fd_count != 0) {
-				xsg_debug("select: interrupted by file descriptor");
-
-				for (l = poll_list; l; l = l->next) {
-					xsg_main_poll_events_t events = 0;
-					xsg_main_poll_t *p = l->data;
-
-					if (xsg_list_find(poll_remove_list, p)) {
-						continue;
-					}
-
-					if (unlikely(p->fd < 0)) {
-						xsg_warning("invalid poll fd: %d",
-								p->fd);
-						continue;
-					}
-
-					if ((p->events & XSG_MAIN_POLL_READ)
-					 && (FD_ISSET(p->fd, &read_fds))) {
-						events |= XSG_MAIN_POLL_READ;
-					}
-					if ((p->events & XSG_MAIN_POLL_WRITE)
-					 && (FD_ISSET(p->fd, &write_fds))) {
-						events |= XSG_MAIN_POLL_WRITE;
-					}
-					if ((p->events & XSG_MAIN_POLL_EXCEPT)
-					 && (FD_ISSET(p->fd, &except_fds))) {
-						events |= XSG_MAIN_POLL_EXCEPT;
-					}
-					if (events) {
-						(p->func)(p->arg, events);
-					}
-				}
-			} else if (time_next_is_update) {
+			if (get_monotonic_time() >= tick_deadline) {
 				break; /* next tick */
 			}
 		}
-		tick++;
+		tick += 1 + tick_skip;
+		tick_skip = 0;
 	}
 }
 
@@ -551,7 +1460,15 @@ init(void)
 	for (fl = init_list; fl; fl = fl->next) {
 		void (*func)(void) = (void (*)(void)) fl->func;
 
-		func();
+		if (unlikely(xsg_profile_enabled)) {
+			uint64_t start = xsg_profile_start();
+
+			func();
+			xsg_profile_stop(xsg_profile_find("init",
+					(void *) func), start);
+		} else {
+			func();
+		}
 	}
 }
 
@@ -589,15 +1506,7 @@ signal_handler_user(int signum)
 {
 	xsg_message("received signal %d: %s", signum, signum2str(signum));
 
-	switch (signum) {
-	case SIGALRM: received_sigalrm = TRUE; return;
-	case SIGCHLD: received_sigchld = TRUE; return;
-	case SIGPIPE: received_sigpipe = TRUE; return;
-	case SIGUSR1: received_sigusr1 = TRUE; return;
-	case SIGUSR2: received_sigusr2 = TRUE; return;
-	case SIGHUP: received_sighup = TRUE; return;
-	default: return;
-	}
+	set_received_signal(signum);
 }
 
 static int
@@ -642,6 +1551,8 @@ xsg_main_loop(uint64_t num)
 	ssigaction(SIGUSR2, &action_user, NULL);
 	ssigaction(SIGHUP,  &action_user, NULL);
 
+	signalfd_init();
+
 	xsg_message("registering shutdown function");
 
 	atexit(shutdown);
@@ -31,9 +31,15 @@ xsg_main_loop(uint64_t num);
 extern void
 xsg_main_set_interval(uint64_t i);
 
+extern void
+xsg_main_set_skip_missed_ticks(bool skip);
+
 extern void
 xsg_main_set_time_error(void);
 
+extern uint64_t
+xsg_main_get_update_count(void);
+
 /******************************************************************************/
 
 #endif /* __MAIN_H__ */
@@ -95,6 +95,7 @@ typedef struct _daemon_t {
 	bool send_alive;
 
 	xsg_list_t *var_list;
+	xsg_list_t *var_list_last;
 } daemon_t;
 
 typedef struct _daemon_var_t {
@@ -116,9 +117,11 @@ typedef struct _daemon_var_t {
 static const char *magic_init = "\nxsysguardd_init_version_1\n";
 
 static xsg_list_t *daemon_list = NULL;
+static xsg_list_t *daemon_list_last = NULL;
 
 static uint32_t daemon_var_count = 0;
 static xsg_list_t *daemon_var_list = NULL;
+static xsg_list_t *daemon_var_list_last = NULL;
 static daemon_var_t **daemon_var_array = NULL;
 
 static uint64_t last_alive_timeout = LAST_ALIVE_TIMEOUT;
@@ -273,7 +276,8 @@ find_daemon(char *command)
 	}
 
 	daemon = xsg_new(daemon_t, 1);
-	daemon_list = xsg_list_append(daemon_list, daemon);
+	daemon_list = xsg_list_append_last(daemon_list, &daemon_list_last,
+			daemon);
 
 	daemon->command = xsg_strdup(command);
 
@@ -307,6 +311,7 @@ find_daemon(char *command)
 	daemon->send_alive = FALSE;
 
 	daemon->var_list = NULL;
+	daemon->var_list_last = NULL;
 
 	return daemon;
 }
@@ -767,6 +772,7 @@ exec_daemon(daemon_t *daemon)
 		sclose(pipe3[1]);
 		return;
 	} else if (pid == 0) {
+		xsg_main_reset_signal_mask();
 		sclose(pipe1[1]);
 		sclose(pipe2[0]);
 		sclose(pipe3[0]);
@@ -1032,8 +1038,10 @@ parse_daemon(
 	daemon_write_buffer_add_var(daemon, update, type,
 			xsg_conf_read_string());
 
-	daemon->var_list = xsg_list_append(daemon->var_list, daemon_var);
-	daemon_var_list = xsg_list_append(daemon_var_list, daemon_var);
+	daemon->var_list = xsg_list_append_last(daemon->var_list,
+			&daemon->var_list_last, daemon_var);
+	daemon_var_list = xsg_list_append_last(daemon_var_list,
+			&daemon_var_list_last, daemon_var);
 	daemon_var_count++;
 }
 
@@ -32,6 +32,7 @@ typedef struct _env_t {
 /******************************************************************************/
 
 static xsg_list_t *env_list = NULL;
+static xsg_list_t *env_list_last = NULL;
 
 /******************************************************************************/
 
@@ -55,7 +56,7 @@ find_env_buffer(const char *name, uint64_t update)
 	e->update = update;
 	e->buffer = xsg_buffer_new();
 
-	env_list = xsg_list_append(env_list, (void *) e);
+	env_list = xsg_list_append_last(env_list, &env_list_last, (void *) e);
 
 	return e->buffer;
 }
@@ -73,8 +74,14 @@ update_envs(uint64_t tick)
 		if (tick % e->update == 0) {
 			const char *value;
 
+			/* NOTE: SetEnv may change the environment while the
+			 * config is parsed, so it is read here */
 			value = xsg_getenv(e->name);
 
+			if (value == NULL) {
+				value = "";
+			}
+
 			xsg_buffer_add(e->buffer, value, strlen(value));
 
 			xsg_buffer_clear(e->buffer);
@@ -46,6 +46,7 @@ typedef struct _exec_t {
 /******************************************************************************/
 
 static xsg_list_t *exec_list = NULL;
+static xsg_list_t *exec_list_last = NULL;
 
 /******************************************************************************/
 
@@ -139,7 +140,7 @@ find_exec_buffer(const char *command, uint64_t update)
 
 	e = xsg_new(exec_t, 1);
 
-	exec_list = xsg_list_append(exec_list, e);
+	exec_list = xsg_list_append_last(exec_list, &exec_list_last, e);
 
 	e->command = xsg_strdup(command);
 
@@ -220,6 +221,7 @@ run_exec(exec_t *e)
 		close(p[1]);
 		return;
 	} else if (pid == 0) {
+		xsg_main_reset_signal_mask();
 		close(p[0]);
 		if (p[1] != STDOUT_FILENO) {
 			if (dup2(p[1], STDOUT_FILENO) != STDOUT_FILENO) {
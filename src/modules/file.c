@@ -19,9 +19,12 @@
  */
 
 #include <xsysguard.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
+#include <stdlib.h>
 
 /******************************************************************************/
 
@@ -29,11 +32,32 @@ typedef struct _file_buffer_t {
 	char *filename;
 	uint64_t update;
 	xsg_buffer_t *buffer;
+	xsg_worker_job_t job;
+	/* filled by read_file in a worker thread */
+	char *data;
+	size_t data_len;
+	size_t data_size;
+	int error;
+	int error_errno;
 } file_buffer_t;
 
+#define FILE_OK			0
+#define FILE_NOT_REGULAR	1
+#define FILE_OPEN_FAILED	2
+#define FILE_READ_FAILED	3
+
 /******************************************************************************/
 
 static xsg_list_t *file_buffer_list = NULL;
+static xsg_list_t *file_buffer_list_last = NULL;
+
+/******************************************************************************/
+
+static void
+read_file(void *arg);
+
+static void
+publish_file(void *arg);
 
 /******************************************************************************/
 
@@ -57,37 +81,69 @@ find_file_buffer(const char *filename, uint64_t update)
 	f->update = update;
 	f->buffer = xsg_buffer_new();
 
-	file_buffer_list = xsg_list_append(file_buffer_list, (void *) f);
+	f->job.sample = read_file;
+	f->job.publish = publish_file;
+	f->job.arg = f;
+
+	f->data = NULL;
+	f->data_len = 0;
+	f->data_size = 0;
+	f->error = FILE_OK;
+	f->error_errno = 0;
+
+	file_buffer_list = xsg_list_append_last(file_buffer_list,
+			&file_buffer_list_last, (void *) f);
 
 	return f->buffer;
 }
 
 /******************************************************************************/
 
+/* NOTE: may run in a worker thread, so no xsg_* functions here */
 static void
-update_file_buffer(file_buffer_t *f)
+read_file(void *arg)
 {
+	file_buffer_t *f = arg;
+	struct stat st;
 	int fd;
 	int e;
 
-	if (!xsg_file_test(f->filename, XSG_FILE_TEST_IS_REGULAR)) {
-		xsg_message("Not a regular file: %s", f->filename);
+	f->data_len = 0;
+	f->error = FILE_OK;
+	f->error_errno = 0;
+
+	if (stat(f->filename, &st) < 0 || !S_ISREG(st.st_mode)) {
+		f->error = FILE_NOT_REGULAR;
 		return;
 	}
 
 	fd = open(f->filename, O_RDONLY | O_NONBLOCK);
 
 	if (fd == -1) {
-		xsg_message("cannot open file %s: %s", f->filename,
-				strerror(errno));
+		f->error = FILE_OPEN_FAILED;
+		f->error_errno = errno;
 		return;
 	}
 
 	while (TRUE) {
-		char buf[4096];
 		ssize_t n;
 
-		n = read(fd, buf, sizeof(buf));
+		if (f->data_size - f->data_len < 4096) {
+			char *data;
+
+			data = realloc(f->data, f->data_size + 4096);
+
+			if (data == NULL) {
+				f->error = FILE_READ_FAILED;
+				f->error_errno = ENOMEM;
+				break;
+			}
+
+			f->data = data;
+			f->data_size += 4096;
+		}
+
+		n = read(fd, f->data + f->data_len, f->data_size - f->data_len);
 
 		if (n == 0) {
 			break;
@@ -97,25 +153,42 @@ update_file_buffer(file_buffer_t *f)
 			continue;
 		}
 
-		if (n == -1 && errno == EAGAIN) {
-			xsg_message("cannot read from file %s: %s", f->filename,
-					strerror(errno));
-			break;
-		}
-
 		if (n == -1) {
-			xsg_message("cannot read from file %s: %s", f->filename,
-					strerror(errno));
+			f->error = FILE_READ_FAILED;
+			f->error_errno = errno;
 			break;
 		}
 
-		xsg_buffer_add(f->buffer, buf, n);
+		f->data_len += n;
 	}
 
 	do {
 		e = close(fd);
 	} while (e == -1 && errno == EINTR);
+}
+
+static void
+publish_file(void *arg)
+{
+	file_buffer_t *f = arg;
+
+	switch (f->error) {
+	case FILE_NOT_REGULAR:
+		xsg_message("Not a regular file: %s", f->filename);
+		return;
+	case FILE_OPEN_FAILED:
+		xsg_message("cannot open file %s: %s", f->filename,
+				strerror(f->error_errno));
+		return;
+	case FILE_READ_FAILED:
+		xsg_message("cannot read from file %s: %s", f->filename,
+				strerror(f->error_errno));
+		break;
+	default:
+		break;
+	}
 
+	xsg_buffer_add(f->buffer, f->data, f->data_len);
 	xsg_buffer_clear(f->buffer);
 }
 
@@ -128,7 +201,7 @@ update_files(uint64_t tick)
 		file_buffer_t *f = l->data;
 
 		if (tick % f->update == 0) {
-			update_file_buffer(f);
+			xsg_worker_submit(&f->job);
 		}
 	}
 }
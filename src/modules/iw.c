@@ -35,9 +35,16 @@
 
 /******************************************************************************/
 
+/* each parsed variable has its own buffer, so the strings of two variables
+ * stay valid side by side until the next update */
+typedef struct _iw_args_t {
+	char *ifname;
+	char buffer[4096];
+	xsg_string_t *string;
+} iw_args_t;
+
 static int skfd = -1;
 
-static char buffer[4096];
 static struct iwreq wrq;
 static struct iw_range range;
 static struct iw_statistics stats;
@@ -78,24 +85,26 @@ dbm2mw(double dbm)
 static const char *
 get_name(void *arg)
 {
-	static char name[IFNAMSIZ + 1];
+	iw_args_t *args = (iw_args_t *) arg;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWNAME, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWNAME, &wrq) < 0) {
 		xsg_debug("get_name: UNKNOWN");
 		return NULL;
 	}
 
-	strncpy(name, wrq.u.name, IFNAMSIZ);
-	name[IFNAMSIZ] = '\0';
+	strncpy(args->buffer, wrq.u.name, IFNAMSIZ);
+	args->buffer[IFNAMSIZ] = '\0';
 
-	xsg_debug("get_name: \"%s\"", name);
-	return name;
+	xsg_debug("get_name: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static double
 get_nwid(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWNWID, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWNWID, &wrq) < 0) {
 		xsg_debug("get_nwid: UNKNOWN");
 		return DNAN;
 	}
@@ -107,9 +116,10 @@ get_nwid(void *arg)
 static double
 get_freq_number(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	double freq;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWFREQ, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWFREQ, &wrq) < 0) {
 		xsg_debug("get_freq_number: UNKNOWN");
 		return DNAN;
 	}
@@ -117,7 +127,7 @@ get_freq_number(void *arg)
 	freq = iw_freq2float(&(wrq.u.freq));
 
 	if (freq < KILO) {
-		if (iw_get_range_info(skfd, arg, &range) >= 0) {
+		if (iw_get_range_info(skfd, args->ifname, &range) >= 0) {
 			iw_channel_to_freq((int) freq, &freq, &range);
 		}
 	}
@@ -129,6 +139,7 @@ get_freq_number(void *arg)
 static const char *
 get_freq_string(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	double freq;
 
 	freq = get_freq_number(arg);
@@ -138,18 +149,19 @@ get_freq_string(void *arg)
 		return NULL;
 	}
 
-	iw_print_freq_value(buffer, sizeof(buffer), freq);
+	iw_print_freq_value(args->buffer, sizeof(args->buffer), freq);
 
-	xsg_debug("get_freq_string: \"%s\"", buffer);
-	return buffer;
+	xsg_debug("get_freq_string: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static double
 get_channel(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	double freq;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWFREQ, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWFREQ, &wrq) < 0) {
 		xsg_debug("get_channel: UNKNOWN");
 		return DNAN;
 	}
@@ -157,7 +169,7 @@ get_channel(void *arg)
 	freq = iw_freq2float(&(wrq.u.freq));
 
 	if (freq >= KILO) {
-		if (iw_get_range_info(skfd, arg, &range) >= 0) {
+		if (iw_get_range_info(skfd, args->ifname, &range) >= 0) {
 			return (double) iw_freq_to_channel(freq, &range);
 		}
 	}
@@ -169,6 +181,7 @@ get_channel(void *arg)
 static const char *
 get_key(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	unsigned char key[IW_ENCODING_TOKEN_MAX];
 	int key_size, key_flags;
 
@@ -176,7 +189,7 @@ get_key(void *arg)
 	wrq.u.data.length = IW_ENCODING_TOKEN_MAX;
 	wrq.u.data.flags = 0;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWENCODE, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWENCODE, &wrq) < 0) {
 		xsg_debug("get_key: UNKNOWN");
 		return NULL;
 	}
@@ -189,15 +202,17 @@ get_key(void *arg)
 		return "off";
 	}
 
-	iw_print_key(buffer, sizeof(buffer), key, key_size, key_flags);
+	iw_print_key(args->buffer, sizeof(args->buffer), key, key_size,
+			key_flags);
 
-	xsg_debug("get_key: \"%s\"", buffer);
-	return buffer;
+	xsg_debug("get_key: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static double
 get_keyid(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	unsigned char key[IW_ENCODING_TOKEN_MAX];
 	int key_size, key_flags;
 
@@ -205,7 +220,7 @@ get_keyid(void *arg)
 	wrq.u.data.length = IW_ENCODING_TOKEN_MAX;
 	wrq.u.data.flags = 0;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWENCODE, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWENCODE, &wrq) < 0) {
 		xsg_debug("get_keyid: UNKNOWN");
 		return DNAN;
 	}
@@ -225,14 +240,16 @@ get_keyid(void *arg)
 static const char *
 get_essid(void *arg)
 {
-	static char essid[IW_ESSID_MAX_SIZE + 1];
+	iw_args_t *args = (iw_args_t *) arg;
 	int essid_on;
 
-	wrq.u.essid.pointer = (caddr_t) essid;
+	memset(args->buffer, 0, IW_ESSID_MAX_SIZE + 2);
+
+	wrq.u.essid.pointer = (caddr_t) args->buffer;
 	wrq.u.essid.length = IW_ESSID_MAX_SIZE + 1;
 	wrq.u.essid.flags = 0;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWESSID, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWESSID, &wrq) < 0) {
 		xsg_debug("get_essid: UNKNOWN");
 		return NULL;
 	}
@@ -240,8 +257,8 @@ get_essid(void *arg)
 	essid_on = wrq.u.data.flags;
 
 	if (essid_on) {
-		xsg_debug("get_essid: \"%s\"", essid);
-		return essid;
+		xsg_debug("get_essid: \"%s\"", args->buffer);
+		return args->buffer;
 	} else {
 		xsg_debug("get_essid: off/any");
 		return "off/any";
@@ -251,7 +268,9 @@ get_essid(void *arg)
 static double
 get_mode_number(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWMODE, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWMODE, &wrq) < 0) {
 		xsg_debug("get_mode_number: UNKNOWN");
 		return DNAN;
 	}
@@ -268,29 +287,33 @@ get_mode_number(void *arg)
 static const char *
 get_mode_string(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWMODE, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWMODE, &wrq) < 0) {
 		xsg_debug("get_mode_string: UNKNOWN");
 		return NULL;
 	}
 
 	if (wrq.u.mode < IW_NUM_OPER_MODE) {
-		strncpy(buffer, iw_operation_mode[wrq.u.mode],
-				sizeof(buffer) - 1);
+		strncpy(args->buffer, iw_operation_mode[wrq.u.mode],
+				sizeof(args->buffer) - 1);
 	} else {
-		strncpy(buffer, iw_operation_mode[IW_NUM_OPER_MODE],
-				sizeof(buffer) - 1);
+		strncpy(args->buffer, iw_operation_mode[IW_NUM_OPER_MODE],
+				sizeof(args->buffer) - 1);
 	}
 
-	buffer[sizeof(buffer) - 1] = '\0';
+	args->buffer[sizeof(args->buffer) - 1] = '\0';
 
-	xsg_debug("get_mode_string: \"%s\"", buffer);
-	return buffer;
+	xsg_debug("get_mode_string: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static double
 get_sens(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWSENS, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWSENS, &wrq) < 0) {
 		xsg_debug("get_sens: UNKNOWN");
 		return DNAN;
 	}
@@ -302,13 +325,15 @@ get_sens(void *arg)
 static const char *
 get_nickname(void *arg)
 {
-	static char nickname[IW_ESSID_MAX_SIZE + 1];
+	iw_args_t *args = (iw_args_t *) arg;
 
-	wrq.u.essid.pointer = (caddr_t) nickname;
+	memset(args->buffer, 0, IW_ESSID_MAX_SIZE + 2);
+
+	wrq.u.essid.pointer = (caddr_t) args->buffer;
 	wrq.u.essid.length = IW_ESSID_MAX_SIZE + 1;
 	wrq.u.essid.flags = 0;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWNICKN, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWNICKN, &wrq) < 0) {
 		xsg_debug("get_nickname: UNKNOWN");
 		return NULL;
 	}
@@ -318,28 +343,32 @@ get_nickname(void *arg)
 		return NULL;
 	}
 
-	xsg_debug("get_nickname: \"%s\"", nickname);
-	return nickname;
+	xsg_debug("get_nickname: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static const char *
 get_ap(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWAP, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWAP, &wrq) < 0) {
 		xsg_debug("get_ap: UNKNOWN");
 		return NULL;
 	}
 
-	iw_sawap_ntop(&(wrq.u.ap_addr), buffer);
+	iw_sawap_ntop(&(wrq.u.ap_addr), args->buffer);
 
-	xsg_debug("get_ap: \"%s\"", buffer);
-	return buffer;
+	xsg_debug("get_ap: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static double
 get_bitrate_number(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWRATE, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWRATE, &wrq) < 0) {
 		xsg_debug("get_bitrate_number: UNKNOWN");
 		return DNAN;
 	}
@@ -351,21 +380,26 @@ get_bitrate_number(void *arg)
 static const char *
 get_bitrate_string(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWRATE, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWRATE, &wrq) < 0) {
 		xsg_debug("get_bitrate_string: UNKNOWN");
 		return NULL;
 	}
 
-	iw_print_bitrate(buffer, sizeof(buffer), wrq.u.bitrate.value);
+	iw_print_bitrate(args->buffer, sizeof(args->buffer),
+			wrq.u.bitrate.value);
 
-	xsg_debug("get_bitrate_string: \"%s\"", buffer);
-	return buffer;
+	xsg_debug("get_bitrate_string: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static double
 get_rts_number(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWRTS, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWRTS, &wrq) < 0) {
 		xsg_debug("get_rts_number: UNKNOWN");
 		return DNAN;
 	}
@@ -382,7 +416,9 @@ get_rts_number(void *arg)
 static const char *
 get_rts_string(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWRTS, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWRTS, &wrq) < 0) {
 		xsg_debug("get_rts_string: UNKNOWN");
 		return NULL;
 	}
@@ -392,16 +428,18 @@ get_rts_string(void *arg)
 		return "off";
 	}
 
-	snprintf(buffer, sizeof(buffer), "%d B", wrq.u.rts.value);
+	snprintf(args->buffer, sizeof(args->buffer), "%d B", wrq.u.rts.value);
 
-	xsg_debug("get_rts_string: \"%s\"", buffer);
-	return buffer;
+	xsg_debug("get_rts_string: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static double
 get_frag_number(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWFRAG, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWFRAG, &wrq) < 0) {
 		xsg_debug("get_frag_number: UNKNOWN");
 		return DNAN;
 	}
@@ -418,7 +456,9 @@ get_frag_number(void *arg)
 static const char *
 get_frag_string(void *arg)
 {
-	if (iw_get_ext(skfd, arg, SIOCGIWFRAG, &wrq) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWFRAG, &wrq) < 0) {
 		xsg_debug("get_frag_string: UNKNOWN");
 		return NULL;
 	}
@@ -428,19 +468,21 @@ get_frag_string(void *arg)
 		return "off";
 	}
 
-	snprintf(buffer, sizeof(buffer), "%d B", wrq.u.frag.value);
+	snprintf(args->buffer, sizeof(args->buffer), "%d B", wrq.u.frag.value);
 
-	xsg_debug("get_frag_string: \"%s\"", buffer);
-	return buffer;
+	xsg_debug("get_frag_string: \"%s\"", args->buffer);
+	return args->buffer;
 }
 
 static const char *
 get_power_management(void *arg)
 {
-	static xsg_string_t *string = NULL;
+	iw_args_t *args = (iw_args_t *) arg;
+	xsg_string_t *string = args->string;
+
 	wrq.u.power.flags = 0;
 
-	if (iw_get_ext(skfd, arg, SIOCGIWPOWER, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWPOWER, &wrq) < 0) {
 		xsg_debug("get_power_management: UNKNOWN");
 		return NULL;
 	}
@@ -450,21 +492,20 @@ get_power_management(void *arg)
 		return "off";
 	}
 
-	if (string == NULL) {
-		string = xsg_string_new(NULL);
-	}
+	xsg_string_truncate(string, 0);
 
 	if (wrq.u.power.flags & IW_POWER_TYPE) {
-		if (iw_get_range_info(skfd, arg, &range) >= 0) {
-			iw_print_pm_value(buffer, sizeof(buffer),
+		if (iw_get_range_info(skfd, args->ifname, &range) >= 0) {
+			iw_print_pm_value(args->buffer, sizeof(args->buffer),
 					wrq.u.power.value, wrq.u.power.flags,
 					range.we_version_compiled);
-			xsg_string_append_len(string, buffer, -1);
+			xsg_string_append_len(string, args->buffer, -1);
 		}
 	}
 
-	iw_print_pm_mode(buffer, sizeof(buffer), wrq.u.power.flags);
-	xsg_string_append_len(string, buffer, -1);
+	iw_print_pm_mode(args->buffer, sizeof(args->buffer),
+			wrq.u.power.flags);
+	xsg_string_append_len(string, args->buffer, -1);
 
 	if (wrq.u.power.flags == IW_POWER_ON) {
 		xsg_string_append_len(string, "on", -1);
@@ -482,7 +523,9 @@ get_power_management(void *arg)
 static double
 get_txpower_dbm(void *arg)
 {
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		xsg_debug("get_txpower_dbm: UNKNOWN");
 		return DNAN;
 	}
@@ -492,7 +535,7 @@ get_txpower_dbm(void *arg)
 		return DNAN;
 	}
 
-	if (iw_get_ext(skfd, arg, SIOCGIWTXPOW, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWTXPOW, &wrq) < 0) {
 		xsg_debug("get_txpower_dbm: UNKNOWN");
 		return DNAN;
 	}
@@ -527,7 +570,9 @@ get_txpower_mw(void *arg)
 static const char *
 get_retry(void *arg)
 {
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		xsg_debug("get_retry: UNKNOWN");
 		return NULL;
 	}
@@ -537,7 +582,7 @@ get_retry(void *arg)
 		return NULL;
 	}
 
-	if (iw_get_ext(skfd, arg, SIOCGIWRETRY, &wrq) < 0) {
+	if (iw_get_ext(skfd, args->ifname, SIOCGIWRETRY, &wrq) < 0) {
 		xsg_debug("get_retry: UNKNOWN");
 		return NULL;
 	}
@@ -553,16 +598,16 @@ get_retry(void *arg)
 	}
 
 	if (wrq.u.retry.flags & IW_RETRY_TYPE) {
-		iw_print_retry_value(buffer, sizeof(buffer),
+		iw_print_retry_value(args->buffer, sizeof(args->buffer),
 				wrq.u.retry.value, wrq.u.retry.flags,
 				range.we_version_compiled);
 
-		if (buffer[0] == ' ') {
-			xsg_debug("get_retry: \"%s\"", buffer + 1);
-			return buffer + 1;
+		if (args->buffer[0] == ' ') {
+			xsg_debug("get_retry: \"%s\"", args->buffer + 1);
+			return args->buffer + 1;
 		} else {
-			xsg_debug("get_retry: \"%s\"", buffer);
-			return buffer;
+			xsg_debug("get_retry: \"%s\"", args->buffer);
+			return args->buffer;
 		}
 	}
 
@@ -573,13 +618,14 @@ get_retry(void *arg)
 static double
 get_stats_quality_quality(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_quality_quality: UNKNOWN");
 		return DNAN;
 	}
@@ -591,13 +637,14 @@ get_stats_quality_quality(void *arg)
 static double
 get_stats_quality_signal(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_quality_signal: UNKNOWN");
 		return DNAN;
 	}
@@ -634,13 +681,14 @@ get_stats_quality_signal(void *arg)
 static double
 get_stats_quality_noise(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_quality_noise: UNKNOWN");
 		return DNAN;
 	}
@@ -677,13 +725,14 @@ get_stats_quality_noise(void *arg)
 static double
 get_stats_discarded_nwid(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		return DNAN;
 	}
 
@@ -693,13 +742,14 @@ get_stats_discarded_nwid(void *arg)
 static double
 get_stats_discarded_code(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_discarded_code: UNKNOWN");
 		return DNAN;
 	}
@@ -712,13 +762,14 @@ get_stats_discarded_code(void *arg)
 static double
 get_stats_discarded_fragment(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_discarded_fragment: UNKNOWN");
 		return DNAN;
 	}
@@ -731,9 +782,10 @@ get_stats_discarded_fragment(void *arg)
 static double
 get_stats_discarded_retries(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
@@ -742,7 +794,7 @@ get_stats_discarded_retries(void *arg)
 		return DNAN;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_discarded_retries: UNKNOWN");
 		return DNAN;
 	}
@@ -755,13 +807,14 @@ get_stats_discarded_retries(void *arg)
 static double
 get_stats_discarded_misc(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_discarded_misc: UNKNOWN");
 		return DNAN;
 	}
@@ -774,9 +827,10 @@ get_stats_discarded_misc(void *arg)
 static double
 get_stats_missed_beacon(void *arg)
 {
+	iw_args_t *args = (iw_args_t *) arg;
 	int has_range = 1;
 
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		has_range = 0;
 	}
 
@@ -785,7 +839,7 @@ get_stats_missed_beacon(void *arg)
 		return DNAN;
 	}
 
-	if (iw_get_stats(skfd, arg, &stats, &range, has_range) < 0) {
+	if (iw_get_stats(skfd, args->ifname, &stats, &range, has_range) < 0) {
 		xsg_debug("get_stats_missed_beacon: UNKNOWN");
 		return DNAN;
 	}
@@ -798,7 +852,9 @@ get_stats_missed_beacon(void *arg)
 static double
 get_range_sensitivity(void *arg)
 {
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		xsg_debug("get_range_sensitivity: UNKNOWN");
 		return DNAN;
 	}
@@ -811,7 +867,9 @@ get_range_sensitivity(void *arg)
 static double
 get_range_max_quality_quality(void *arg)
 {
-	if (iw_get_range_info(skfd, arg, &range) < 0) {
+	iw_args_t *args = (iw_args_t *) arg;
+
+	if (iw_get_range_info(skfd, args->ifname, &range) < 0) {
 		xsg_debug("get_range_max_quality_quality: UNKNOWN");
 		return DNAN;
 	}
@@ -853,6 +911,7 @@ parse_iw(
 	void **arg
 )
 {
+	iw_args_t *args;
 	char *ifname;
 
 	ifname = xsg_conf_read_string();
@@ -872,7 +931,12 @@ parse_iw(
 		}
 	}
 
-	*arg = (void *) ifname;
+	args = xsg_new(iw_args_t, 1);
+	args->ifname = ifname;
+	args->buffer[0] = '\0';
+	args->string = xsg_string_new(NULL);
+
+	*arg = (void *) args;
 
 	if (xsg_conf_find_command("config")) {
 		if (xsg_conf_find_command("name")) {
@@ -991,6 +1055,7 @@ static const char *
 help_iw(void)
 {
 	static xsg_string_t *string = NULL;
+	static iw_args_t args;
 	xsg_list_t *l;
 	int i = 0;
 
@@ -1023,108 +1088,114 @@ help_iw(void)
 	for (l = device_list; l; l = l->next) {
 		char *ifname = (char *) l->data;
 
+		args.ifname = ifname;
+
+		if (args.string == NULL) {
+			args.string = xsg_string_new(NULL);
+		}
+
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "config:name",
-				get_name(ifname));
+				get_name(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "config:nwid",
-				get_nwid(ifname));
+				get_nwid(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "config:freq",
-				get_freq_number(ifname));
+				get_freq_number(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "config:freq",
-				get_freq_string(ifname));
+				get_freq_string(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "config:channel",
-				get_channel(ifname));
+				get_channel(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "config:key",
-				get_key(ifname));
+				get_key(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "config:keyid",
-				get_keyid(ifname));
+				get_keyid(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "config:essid",
-				get_essid(ifname));
+				get_essid(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "config:mode",
-				get_mode_number(ifname));
+				get_mode_number(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "config:mode",
-				get_mode_string(ifname));
+				get_mode_string(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "info:sensitivity",
-				get_sens(ifname));
+				get_sens(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "info:nickname",
-				get_nickname(ifname));
+				get_nickname(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "info:access_point",
-				get_ap(ifname));
+				get_ap(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "info:bitrate",
-				get_bitrate_number(ifname));
+				get_bitrate_number(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "info:bitrate",
-				get_bitrate_string(ifname));
+				get_bitrate_string(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "info:rts",
-				get_rts_number(ifname));
+				get_rts_number(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "info:rts",
-				get_rts_string(ifname));
+				get_rts_string(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "info:fragment",
-				get_frag_number(ifname));
+				get_frag_number(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "info:fragment",
-				get_frag_string(ifname));
+				get_frag_string(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "info:power_management",
-				get_power_management(ifname));
+				get_power_management(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "info:txpower:dbm",
-				get_txpower_dbm(ifname));
+				get_txpower_dbm(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.2f\n",
 				XSG_MODULE_NAME, ifname, "info:txpower:mw",
-				get_txpower_mw(ifname));
+				get_txpower_mw(&args));
 		xsg_string_append_printf(string, "S %s:%s:%-36s%s\n",
 				XSG_MODULE_NAME, ifname, "info:retry",
-				get_retry(ifname));
+				get_retry(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:quality:quality",
-				get_stats_quality_quality(ifname));
+				get_stats_quality_quality(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:quality:signal",
-				get_stats_quality_signal(ifname));
+				get_stats_quality_signal(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:quality:noise",
-				get_stats_quality_noise(ifname));
+				get_stats_quality_noise(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:discarded:nwid",
-				get_stats_discarded_nwid(ifname));
+				get_stats_discarded_nwid(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:discarded:code",
-				get_stats_discarded_code(ifname));
+				get_stats_discarded_code(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:discarded:fragment",
-				get_stats_discarded_fragment(ifname));
+				get_stats_discarded_fragment(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:discarded:retries",
-				get_stats_discarded_retries(ifname));
+				get_stats_discarded_retries(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:discarded:misc",
-				get_stats_discarded_misc(ifname));
+				get_stats_discarded_misc(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "stats:missed:beacon",
-				get_stats_missed_beacon(ifname));
+				get_stats_missed_beacon(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "range:sensitivity",
-				get_range_sensitivity(ifname));
+				get_range_sensitivity(&args));
 		xsg_string_append_printf(string, "N %s:%s:%-36s%.0f\n",
 				XSG_MODULE_NAME, ifname, "range:max_quality:quality",
-				get_range_max_quality_quality(ifname));
+				get_range_max_quality_quality(&args));
 	}
 
 	return string->str;
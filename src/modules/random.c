@@ -223,6 +223,7 @@ typedef struct _random_t {
 /******************************************************************************/
 
 static xsg_list_t *random_list = NULL;
+static xsg_list_t *random_list_last = NULL;
 
 /******************************************************************************/
 
@@ -278,7 +279,8 @@ parse_random(
 	*arg = (void *) random;
 	*num = get_random;
 
-	random_list = xsg_list_append(random_list, random);
+	random_list = xsg_list_append_last(random_list, &random_list_last,
+			random);
 
 	xsg_main_add_update_func(update_random);
 	xsg_main_add_init_func(init_random);
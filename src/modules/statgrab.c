@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 
 /******************************************************************************/
 
@@ -2299,6 +2300,112 @@ get_network_io_stats_collisions(void *arg)
 	}
 }
 
+/******************************************************************************
+ *
+ * network_io_stats vectors (interface name "all")
+ *
+ ******************************************************************************/
+
+typedef struct _network_io_vector_t {
+	network_io_stats_diff_t *d;	/* NULL for network_io_stats */
+	size_t offset;			/* of the value in sg_network_io_stats */
+	double *values;
+	unsigned size;
+} network_io_vector_t;
+
+/******************************************************************************/
+
+static const double *
+get_network_io_vector(void *arg, unsigned *len)
+{
+	network_io_vector_t *v;
+	sg_network_io_stats *stats;
+	unsigned entries, i;
+
+	v = (network_io_vector_t *) arg;
+
+	if (v->d != NULL) {
+		stats = v->d->diff;
+		entries = v->d->entries;
+	} else {
+		stats = network_io_stats;
+		entries = network_io_entries;
+	}
+
+	if (stats == NULL) {
+		entries = 0;
+	}
+
+	if (entries > v->size) {
+		v->values = xsg_renew(double, v->values, entries);
+		v->size = entries;
+	}
+
+	/* interfaces are sorted by name */
+	for (i = 0; i < entries; i++) {
+		char *value = (char *) &stats[i] + v->offset;
+
+		v->values[i] = (double) *(long long *) value;
+	}
+
+	xsg_debug("get_network_io_vector: %u interfaces", entries);
+
+	*len = entries;
+
+	return v->values;
+}
+
+static double
+get_network_io_vector_len(void *arg)
+{
+	unsigned len;
+
+	get_network_io_vector(arg, &len);
+
+	return (double) len;
+}
+
+/******************************************************************************/
+
+static void
+parse_network_io_vector(
+	network_io_stats_diff_t *d,
+	double (**num)(void *),
+	void **arg
+)
+{
+	network_io_vector_t *v;
+
+	v = xsg_new(network_io_vector_t, 1);
+	v->d = d;
+	v->values = NULL;
+	v->size = 0;
+
+	if (xsg_conf_find_command("tx")) {
+		v->offset = offsetof(sg_network_io_stats, tx);
+	} else if (xsg_conf_find_command("rx")) {
+		v->offset = offsetof(sg_network_io_stats, rx);
+	} else if (xsg_conf_find_command("ipackets")) {
+		v->offset = offsetof(sg_network_io_stats, ipackets);
+	} else if (xsg_conf_find_command("opackets")) {
+		v->offset = offsetof(sg_network_io_stats, opackets);
+	} else if (xsg_conf_find_command("ierrors")) {
+		v->offset = offsetof(sg_network_io_stats, ierrors);
+	} else if (xsg_conf_find_command("oerrors")) {
+		v->offset = offsetof(sg_network_io_stats, oerrors);
+	} else if (xsg_conf_find_command("collisions")) {
+		v->offset = offsetof(sg_network_io_stats, collisions);
+	} else {
+		xsg_conf_error("tx, rx, ipackets, opackets, ierrors, oerrors "
+				"or collisions expected");
+	}
+
+	*num = get_network_io_vector_len;
+	*arg = (void *) v;
+
+	xsg_rpn_set_vector(*num, *arg, get_network_io_vector);
+}
+
 /******************************************************************************/
 
 static void
@@ -2311,6 +2418,12 @@ parse_network_io_stats(
 {
 	*arg = (void *) xsg_conf_read_string();
 
+	if (!strcmp(*arg, "all")) {
+		xsg_free(*arg);
+		parse_network_io_vector(NULL, num, arg);
+		return;
+	}
+
 	if (!strcmp(*arg, "*")) {
 		get_network_io_stats(0);
 
@@ -2555,6 +2668,13 @@ parse_network_io_stats_diff(
 
 	interface_name = xsg_conf_read_string();
 
+	if (!strcmp(interface_name, "all")) {
+		xsg_free(interface_name);
+		parse_network_io_vector(find_network_io_stats_diff(update),
+				num, arg);
+		return;
+	}
+
 	if (!strcmp(interface_name, "*")) {
 		get_network_io_stats(0);
 
@@ -3774,6 +3894,55 @@ shutdown_stats(void)
 
 /******************************************************************************/
 
+static const char * const stat_names[] = {
+	"host_info",
+	"cpu_stats",
+	"cpu_stats_diff",
+	"cpu_percents",
+	"mem_stats",
+	"load_stats",
+	"user_stats",
+	"swap_stats",
+	"fs_stats",
+	"disk_io_stats",
+	"disk_io_stats_diff",
+	"network_io_stats",
+	"network_io_stats_diff",
+	"network_iface_stats",
+	"page_stats",
+	"page_stats_diff",
+	"process_stats",
+	"process_count",
+};
+
+static xsg_conf_keywords_t stat_keywords = XSG_CONF_KEYWORDS(stat_names);
+
+/* indexed by the ids of stat_keywords */
+static const struct {
+	void (*parse)(uint64_t update, double (**num)(void *),
+			const char *(**str)(void *), void **arg);
+	void (*get)(uint64_t update);
+} stat_funcs[] = {
+	{ parse_host_info, get_host_info },
+	{ parse_cpu_stats, get_cpu_stats },
+	{ parse_cpu_stats_diff, get_cpu_stats_diff },
+	{ parse_cpu_percents, get_cpu_percents },
+	{ parse_mem_stats, get_mem_stats },
+	{ parse_load_stats, get_load_stats },
+	{ parse_user_stats, get_user_stats },
+	{ parse_swap_stats, get_swap_stats },
+	{ parse_fs_stats, get_fs_stats },
+	{ parse_disk_io_stats, get_disk_io_stats },
+	{ parse_disk_io_stats_diff, get_disk_io_stats_diff },
+	{ parse_network_io_stats, get_network_io_stats },
+	{ parse_network_io_stats_diff, get_network_io_stats_diff },
+	{ parse_network_iface_stats, get_network_iface_stats },
+	{ parse_page_stats, get_page_stats },
+	{ parse_page_stats_diff, get_page_stats_diff },
+	{ parse_process_stats, get_process_stats },
+	{ parse_process_count, get_process_count },
+};
+
 static void
 parse_statgrab(
 	uint64_t update,
@@ -3783,65 +3952,15 @@ parse_statgrab(
 	void **arg
 )
 {
+	int id;
+
 	xsg_main_add_init_func(init_stats);
 	xsg_main_add_update_func(update_stats);
 	xsg_main_add_shutdown_func(shutdown_stats);
 
-	if (xsg_conf_find_command("host_info")){
-		parse_host_info(update, num, str, arg);
-		add_stat(update, get_host_info);
-	} else if (xsg_conf_find_command("cpu_stats")) {
-		parse_cpu_stats(update, num, str, arg);
-		add_stat(update, get_cpu_stats);
-	} else if (xsg_conf_find_command("cpu_stats_diff")) {
-		parse_cpu_stats_diff(update, num, str, arg);
-		add_stat(update, get_cpu_stats_diff);
-	} else if (xsg_conf_find_command("cpu_percents")) {
-		parse_cpu_percents(update, num, str, arg);
-		add_stat(update, get_cpu_percents);
-	} else if (xsg_conf_find_command("mem_stats")) {
-		parse_mem_stats(update, num, str, arg);
-		add_stat(update, get_mem_stats);
-	} else if (xsg_conf_find_command("load_stats")) {
-		parse_load_stats(update, num, str, arg);
-		add_stat(update, get_load_stats);
-	} else if (xsg_conf_find_command("user_stats")) {
-		parse_user_stats(update, num, str, arg);
-		add_stat(update, get_user_stats);
-	} else if (xsg_conf_find_command("swap_stats")) {
-		parse_swap_stats(update, num, str, arg);
-		add_stat(update, get_swap_stats);
-	} else if (xsg_conf_find_command("fs_stats")) {
-		parse_fs_stats(update, num, str, arg);
-		add_stat(update, get_fs_stats);
-	} else if (xsg_conf_find_command("disk_io_stats")) {
-		parse_disk_io_stats(update, num, str, arg);
-		add_stat(update, get_disk_io_stats);
-	} else if (xsg_conf_find_command("disk_io_stats_diff")) {
-		parse_disk_io_stats_diff(update, num, str, arg);
-		add_stat(update, get_disk_io_stats_diff);
-	} else if (xsg_conf_find_command("network_io_stats")) {
-		parse_network_io_stats(update, num, str, arg);
-		add_stat(update, get_network_io_stats);
-	} else if (xsg_conf_find_command("network_io_stats_diff")) {
-		parse_network_io_stats_diff(update, num, str, arg);
-		add_stat(update, get_network_io_stats_diff);
-	} else if (xsg_conf_find_command("network_iface_stats")) {
-		parse_network_iface_stats(update, num, str, arg);
-		add_stat(update, get_network_iface_stats);
-	} else if (xsg_conf_find_command("page_stats")) {
-		parse_page_stats(update, num, str, arg);
-		add_stat(update, get_page_stats);
-	} else if (xsg_conf_find_command("page_stats_diff")) {
-		parse_page_stats_diff(update, num, str, arg);
-		add_stat(update, get_page_stats_diff);
-	} else if (xsg_conf_find_command("process_stats")) {
-		parse_process_stats(update, num, str, arg);
-		add_stat(update, get_process_stats);
-	} else if (xsg_conf_find_command("process_count")) {
-		parse_process_count(update, num, str, arg);
-		add_stat(update, get_process_count);
-	} else {
+	id = xsg_conf_find_keyword(&stat_keywords);
+
+	if (id < 0) {
 		xsg_conf_error("host_info, cpu_stats, cpu_stats_diff, "
 				"cpu_percents, mem_stats, load_stats, "
 				"user_stats, swap_stats, fs_stats, "
@@ -3851,6 +3970,11 @@ parse_statgrab(
 				"page_stats_diff, process_stats or "
 				"process_count expected");
 	}
+
+	stat_funcs[id].parse(update, num, str, arg);
+	add_stat(update, stat_funcs[id].get);
+
+	xsg_rpn_set_pure(*num, *str, *arg);
 }
 
 static void
@@ -3887,6 +4011,15 @@ help3n0(xsg_string_t *string, const char *s1, const char *s2, const char *s3, do
 	xsg_string_append_printf(string, "%.0f\n", num);
 }
 
+static void
+help3v(xsg_string_t *string, const char *s1, const char *s2, const char *s3, size_t len)
+{
+	xsg_string_append_printf(string, "V %s:%s:%s:%s ",
+			XSG_MODULE_NAME, s1, s2, s3);
+	help_align(string);
+	xsg_string_append_printf(string, "[%u]\n", (unsigned) len);
+}
+
 static void
 help2n2(xsg_string_t *string, const char *s1, const char *s2, double num)
 {
@@ -4133,6 +4266,13 @@ help_statgrab(void)
 		help3n0(string, "network_io_stats_diff", s, "collisions", 0.0);
 		xsg_string_append_c(string, '\n');
 	}
+	help3v(string, "network_io_stats", "all", "tx", network_io_entries);
+	help3v(string, "network_io_stats", "all", "rx", network_io_entries);
+	help3v(string, "network_io_stats_diff", "all", "tx",
+			network_io_entries);
+	help3v(string, "network_io_stats_diff", "all", "rx",
+			network_io_entries);
+	xsg_string_append_c(string, '\n');
 
 	get_network_iface_stats(0);
 	for (i = 0; i < network_iface_entries; i++) {
@@ -34,6 +34,102 @@ get_tick(void *arg)
 	return d;
 }
 
+static double
+get_jitter(void *arg)
+{
+	double d;
+
+	d = (double) xsg_main_get_tick_jitter() / 1000.0;
+
+	xsg_debug("get_jitter: %f", d);
+
+	return d;
+}
+
+static double
+get_jitter_max(void *arg)
+{
+	double d;
+
+	d = (double) xsg_main_get_tick_jitter_max() / 1000.0;
+
+	xsg_debug("get_jitter_max: %f", d);
+
+	return d;
+}
+
+static double
+get_jitter_avg(void *arg)
+{
+	double d;
+
+	d = (double) xsg_main_get_tick_jitter_avg() / 1000.0;
+
+	xsg_debug("get_jitter_avg: %f", d);
+
+	return d;
+}
+
+static double
+get_work(void *arg)
+{
+	double d;
+
+	d = (double) xsg_main_get_tick_work() / 1000.0;
+
+	xsg_debug("get_work: %f", d);
+
+	return d;
+}
+
+static double
+get_work_max(void *arg)
+{
+	double d;
+
+	d = (double) xsg_main_get_tick_work_max() / 1000.0;
+
+	xsg_debug("get_work_max: %f", d);
+
+	return d;
+}
+
+static double
+get_work_avg(void *arg)
+{
+	double d;
+
+	d = (double) xsg_main_get_tick_work_avg() / 1000.0;
+
+	xsg_debug("get_work_avg: %f", d);
+
+	return d;
+}
+
+static double
+get_overruns(void *arg)
+{
+	double d;
+
+	d = xsg_main_get_tick_overruns();
+
+	xsg_debug("get_overruns: %f", d);
+
+	return d;
+}
+
+static double
+get_missed(void *arg)
+{
+	double d;
+
+	d = xsg_main_get_tick_missed();
+
+	xsg_debug("get_missed: %f", d);
+
+	return d;
+}
+
 /******************************************************************************/
 
 static void
@@ -45,22 +141,60 @@ parse_tick(
 	void **arg
 )
 {
-	*num = get_tick;
+	if (xsg_conf_find_command("jitter")) {
+		*num = get_jitter;
+	} else if (xsg_conf_find_command("jitter_max")) {
+		*num = get_jitter_max;
+	} else if (xsg_conf_find_command("jitter_avg")) {
+		*num = get_jitter_avg;
+	} else if (xsg_conf_find_command("work")) {
+		*num = get_work;
+	} else if (xsg_conf_find_command("work_max")) {
+		*num = get_work_max;
+	} else if (xsg_conf_find_command("work_avg")) {
+		*num = get_work_avg;
+	} else if (xsg_conf_find_command("overruns")) {
+		*num = get_overruns;
+	} else if (xsg_conf_find_command("missed")) {
+		*num = get_missed;
+	} else {
+		*num = get_tick;
+	}
 }
 
 static const char *
 help_tick(void)
 {
-	static char *string = NULL;
+	static xsg_string_t *string = NULL;
 
 	if (string == NULL) {
-		xsg_asprintf(&string, "N %s\n", XSG_MODULE_NAME);
+		string = xsg_string_new(NULL);
+	} else {
+		xsg_string_truncate(string, 0);
 	}
 
-	return string;
+	xsg_string_append_printf(string, "N %s\n", XSG_MODULE_NAME);
+	xsg_string_append_printf(string, "N %s:%-20s%.3f\n", XSG_MODULE_NAME,
+			"jitter", get_jitter(NULL));
+	xsg_string_append_printf(string, "N %s:%-20s%.3f\n", XSG_MODULE_NAME,
+			"jitter_max", get_jitter_max(NULL));
+	xsg_string_append_printf(string, "N %s:%-20s%.3f\n", XSG_MODULE_NAME,
+			"jitter_avg", get_jitter_avg(NULL));
+	xsg_string_append_printf(string, "N %s:%-20s%.3f\n", XSG_MODULE_NAME,
+			"work", get_work(NULL));
+	xsg_string_append_printf(string, "N %s:%-20s%.3f\n", XSG_MODULE_NAME,
+			"work_max", get_work_max(NULL));
+	xsg_string_append_printf(string, "N %s:%-20s%.3f\n", XSG_MODULE_NAME,
+			"work_avg", get_work_avg(NULL));
+	xsg_string_append_printf(string, "N %s:%-20s%.0f\n", XSG_MODULE_NAME,
+			"overruns", get_overruns(NULL));
+	xsg_string_append_printf(string, "N %s:%-20s%.0f\n", XSG_MODULE_NAME,
+			"missed", get_missed(NULL));
+
+	return string->str;
 }
 
 /******************************************************************************/
 
-XSG_MODULE(parse_tick, help_tick, "get current tick");
+XSG_MODULE(parse_tick, help_tick, "get current tick and main loop timing");
 
@@ -111,6 +111,11 @@ parse_uname(
 	} else {
 		xsg_conf_error("sysname, nodename, release, version or machine expected");
 	}
+
+	/* NOTE: the nodename can be changed at runtime */
+	if (*str != get_nodename) {
+		xsg_rpn_set_static(NULL, *str, NULL);
+	}
 }
 
 static const char *
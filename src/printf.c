@@ -59,6 +59,7 @@ struct _xsg_printf_t {
 /******************************************************************************/
 
 static xsg_list_t *printf_list = NULL;
+static xsg_list_t *printf_list_last = NULL;
 
 /******************************************************************************/
 
@@ -249,7 +250,7 @@ xsg_printf_new(const char *format)
 
 	p->next_var = p->var_list;
 
-	printf_list = xsg_list_append(printf_list, p);
+	printf_list = xsg_list_append_last(printf_list, &printf_list_last, p);
 
 	return p;
 }
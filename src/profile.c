@@ -0,0 +1,300 @@
+/* profile.c
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Profiling mode (--profile): the main loop, the RPN engine and the widgets
+ * time their callbacks and aggregate the latencies in log2 histograms. The
+ * histograms are printed to stderr on SIGUSR1 and at exit.
+ */
+
+#include <xsysguard.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+#include <dlfcn.h>
+
+#include "profile.h"
+
+/******************************************************************************/
+
+/* bucket 0 counts latencies below 1 ns, bucket i latencies in
+ * [2^(i-1), 2^i) ns */
+#define BUCKETS 64
+
+struct _xsg_profile_t {
+	const char *category;
+	char *name;
+	void *func;
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[BUCKETS];
+};
+
+/******************************************************************************/
+
+bool xsg_profile_enabled = FALSE;
+
+static xsg_list_t *profile_list = NULL;
+
+static xsg_hash_table_t *func_table = NULL;
+
+/******************************************************************************/
+
+static uint64_t
+get_time_nsec(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if (likely(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)) {
+		return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+	}
+#endif
+	{
+		struct timeval tv;
+
+		xsg_gettimeofday(&tv, NULL);
+
+		return (uint64_t) tv.tv_sec * 1000000000
+			+ (uint64_t) tv.tv_usec * 1000;
+	}
+}
+
+/******************************************************************************/
+
+static xsg_profile_t *
+profile_new(const char *category, const char *name, void *func)
+{
+	xsg_profile_t *profile;
+
+	profile = xsg_new0(xsg_profile_t, 1);
+
+	profile->category = category;
+	profile->name = name ? xsg_strdup(name) : NULL;
+	profile->func = func;
+
+	profile_list = xsg_list_prepend(profile_list, profile);
+
+	return profile;
+}
+
+xsg_profile_t *
+xsg_profile_new(const char *category, const char *name)
+{
+	if (!xsg_profile_enabled) {
+		return NULL;
+	}
+
+	return profile_new(category, name, NULL);
+}
+
+xsg_profile_t *
+xsg_profile_find(const char *category, void *func)
+{
+	xsg_profile_t *profile;
+
+	profile = xsg_hash_table_lookup(func_table, func);
+
+	if (unlikely(profile == NULL)) {
+		profile = profile_new(category, NULL, func);
+		xsg_hash_table_insert(func_table, func, profile);
+	}
+
+	return profile;
+}
+
+/******************************************************************************/
+
+uint64_t
+xsg_profile_start(void)
+{
+	return get_time_nsec();
+}
+
+void
+xsg_profile_stop(xsg_profile_t *profile, uint64_t start)
+{
+	uint64_t t;
+	unsigned i;
+
+	if (profile == NULL) {
+		return;
+	}
+
+	t = get_time_nsec() - start;
+
+	for (i = 0; i < BUCKETS - 1 && (t >> i) != 0; i++) {
+		;
+	}
+
+	profile->buckets[i]++;
+	profile->count++;
+	profile->sum += t;
+	profile->max = MAX(profile->max, t);
+}
+
+/******************************************************************************/
+
+/* upper bound of the bucket containing the given percentile */
+static double
+percentile(xsg_profile_t *profile, unsigned percent)
+{
+	uint64_t rank, n = 0;
+	unsigned i;
+
+	rank = (profile->count * percent + 99) / 100;
+
+	for (i = 0; i < BUCKETS; i++) {
+		n += profile->buckets[i];
+
+		if (n >= rank) {
+			break;
+		}
+	}
+
+	if (i == 0) {
+		return 0.0;
+	}
+
+	return MIN(ldexp(1.0, i), (double) profile->max) / 1000.0;
+}
+
+static const char *
+profile_name(xsg_profile_t *profile)
+{
+	static char buffer[256];
+	Dl_info info;
+
+	if (profile->name != NULL) {
+		return profile->name;
+	}
+
+	/* NOTE: static functions have no dynamic symbol, print the offset
+	 * into the shared object instead (see addr2line) */
+	if (dladdr(profile->func, &info) && info.dli_fname != NULL) {
+		const char *base = strrchr(info.dli_fname, '/');
+
+		base = base ? base + 1 : info.dli_fname;
+
+		if (info.dli_sname != NULL) {
+			snprintf(buffer, sizeof(buffer), "%s (%s)",
+					info.dli_sname, base);
+		} else {
+			snprintf(buffer, sizeof(buffer), "%s+0x%lx", base,
+					(unsigned long) ((char *) profile->func
+					- (char *) info.dli_fbase));
+		}
+	} else {
+		snprintf(buffer, sizeof(buffer), "%p", profile->func);
+	}
+
+	return buffer;
+}
+
+static int
+compare_sum(const void *a, const void *b)
+{
+	const xsg_profile_t *pa = *(const xsg_profile_t **) a;
+	const xsg_profile_t *pb = *(const xsg_profile_t **) b;
+
+	if (pa->sum < pb->sum) {
+		return 1;
+	} else if (pa->sum > pb->sum) {
+		return -1;
+	} else {
+		return 0;
+	}
+}
+
+void
+xsg_profile_dump(void)
+{
+	xsg_profile_t **profiles;
+	xsg_list_t *l;
+	unsigned i, n;
+
+	if (!xsg_profile_enabled) {
+		return;
+	}
+
+	n = xsg_list_length(profile_list);
+
+	profiles = xsg_new(xsg_profile_t *, n + 1);
+
+	for (i = 0, l = profile_list; l; l = l->next) {
+		profiles[i++] = l->data;
+	}
+
+	qsort(profiles, n, sizeof(xsg_profile_t *), compare_sum);
+
+	fprintf(stderr, "%-8s %10s %12s %10s %10s %10s %10s  %s\n",
+			"category", "calls", "total[ms]", "avg[us]",
+			"p50[us]", "p99[us]", "max[us]", "function");
+
+	for (i = 0; i < n; i++) {
+		xsg_profile_t *p = profiles[i];
+
+		if (p->count == 0) {
+			continue;
+		}
+
+		fprintf(stderr, "%-8s %10"PRIu64" %12.3f %10.3f %10.3f %10.3f "
+				"%10.3f  %s\n", p->category, p->count,
+				(double) p->sum / 1000000.0,
+				(double) p->sum / p->count / 1000.0,
+				percentile(p, 50), percentile(p, 99),
+				(double) p->max / 1000.0, profile_name(p));
+	}
+
+	fflush(stderr);
+
+	xsg_free(profiles);
+}
+
+/******************************************************************************/
+
+static void
+signal_handler_profile(int signum)
+{
+	xsg_profile_dump();
+}
+
+void
+xsg_profile_enable(void)
+{
+	if (xsg_profile_enabled) {
+		return;
+	}
+
+	xsg_message("enabling profiling mode");
+
+	xsg_profile_enabled = TRUE;
+
+	func_table = xsg_hash_table_new(xsg_direct_hash, xsg_direct_equal);
+
+	xsg_main_add_signal_handler(signal_handler_profile, SIGUSR1);
+	xsg_main_add_shutdown_func(xsg_profile_dump);
+}
+
@@ -0,0 +1,55 @@
+/* profile.h
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__ 1
+
+#include <xsysguard.h>
+
+/******************************************************************************/
+
+typedef struct _xsg_profile_t xsg_profile_t;
+
+extern bool xsg_profile_enabled;
+
+extern void
+xsg_profile_enable(void);
+
+/* a named entry (e.g. a config line) or one for a function pointer, whose
+ * name is resolved with dladdr when the profile is printed */
+extern xsg_profile_t *
+xsg_profile_new(const char *category, const char *name);
+
+extern xsg_profile_t *
+xsg_profile_find(const char *category, void *func);
+
+extern uint64_t
+xsg_profile_start(void);
+
+extern void
+xsg_profile_stop(xsg_profile_t *profile, uint64_t start);
+
+extern void
+xsg_profile_dump(void);
+
+/******************************************************************************/
+
+#endif /* __PROFILE_H__ */
+
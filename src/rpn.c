@@ -24,24 +24,66 @@
 #include <string.h>
 #include <strings.h>
 #include <alloca.h>
+#include <time.h>
 
 #include "rpn.h"
 #include "var.h"
 #include "conf.h"
 #include "modules.h"
+#include "profile.h"
+#include "main.h"
 
 /******************************************************************************/
 
+/* LOAD and STORE registers: ids are resolved to dense slots while parsing,
+ * each expression has its own heap file, GLOAD and GSTORE share one */
 typedef struct _heap_t {
-	uint32_t id;
 	double num;
 	xsg_string_t *str;
 } heap_t;
 
+typedef struct _heap_file_t {
+	uint32_t *ids;
+	heap_t *heaps;
+	unsigned len;
+} heap_file_t;
+
+/* pure module getters, sampled at most once per update count */
+typedef struct _cache_t {
+	double (*num_load)(void *arg);
+	const char *(*str_load)(void *arg);
+	void *arg;
+	uint64_t num_count;
+	uint64_t str_count;
+	double num;
+	const char *str;
+	bool constant;		/* value never changes after init */
+	uint64_t version;	/* bumped whenever a sample differs */
+	xsg_string_t *seen;	/* last string, kept for tracked expressions */
+} cache_t;
+
+/* module getters returning a vector, see xsg_rpn_set_vector */
+typedef struct _vector_t {
+	double (*num_load)(void *arg);
+	void *arg;
+	const double *(*vec_load)(void *arg, unsigned *len);
+} vector_t;
+
+/* number sub-expressions shared by several expressions */
+typedef struct _shared_t shared_t;
+
+typedef struct _insn_t insn_t;
+
 struct _xsg_rpn_t {
 	xsg_list_t *op_list;
-	xsg_string_t *stack;	/* S=string, N=number, X=both */
-	xsg_list_t *heap_list;
+	insn_t *insns;
+	xsg_string_t *stack;	/* S=string, N=number, X=both, V=vector */
+	heap_file_t heap_file;
+	xsg_profile_t *profile;
+	cache_t **sources;	/* pure getters the value depends on */
+	unsigned source_count;
+	bool tracked;		/* value only changes with its sources */
+	uint64_t version;	/* sum of the source versions last seen */
 };
 
 typedef struct _op_t {
@@ -50,41 +92,151 @@ typedef struct _op_t {
 	double (*num_load)(void *arg);
 	const char *(*str_load)(void *arg);
 	void *arg;
+	void (*op_state)(void *arg);	/* ops keeping their state in arg */
+	const double *(*vec_load)(void *arg, unsigned *len);
+	unsigned char pops;	/* elements taken from the stack */
+	unsigned char pushes;	/* elements pushed onto the stack */
+	char type;		/* S, N, X or V if pushes == 1 */
+	heap_file_t *heap_file;	/* LOAD and STORE: arg is heaps[slot] */
+	unsigned slot;
 } op_t;
 
+/* op_list is compiled into a flat array of instructions: the hot number
+ * ops are executed inline and frequent sequences are fused into
+ * superinstructions, everything else calls the op function */
+
+enum {
+	INSN_END,
+	INSN_OP,
+	INSN_OP_STATE,
+	INSN_LOAD_NUM,
+	INSN_LOAD_STR,
+	INSN_LOAD_BOTH,
+	INSN_LOAD_HEAP,
+	INSN_LOAD_VEC,
+	INSN_CONST,
+	INSN_STORE,
+	INSN_ADD,
+	INSN_SUB,
+	INSN_MUL,
+	INSN_DIV,
+	INSN_LIMIT,
+	INSN_LOAD_ADD,		/* load ADD */
+	INSN_LOAD_SUB,		/* load SUB */
+	INSN_LOAD_MUL,		/* load MUL */
+	INSN_LOAD_DIV,		/* load DIV */
+	INSN_CONST_ADD,		/* number ADD */
+	INSN_CONST_SUB,		/* number SUB */
+	INSN_CONST_MUL,		/* number MUL */
+	INSN_CONST_DIV,		/* number DIV */
+	INSN_LOAD_LOAD_DIV,	/* load load DIV */
+	INSN_LOAD_LOAD_DIV_MUL,	/* load load DIV number MUL */
+	INSN_CONST_LIMIT,	/* number number LIMIT */
+	INSN_SHARED,		/* shared sub-expression */
+	INSN_COUNT
+};
+
+struct _insn_t {
+	unsigned code;
+	char store;		/* S=string, N=number, X=both */
+	void (*op)(void);
+	void (*op_state)(void *arg);
+	double (*num_load)(void *arg);
+	const char *(*str_load)(void *arg);
+	const double *(*vec_load)(void *arg, unsigned *len);
+	void *arg;
+	double (*num_load2)(void *arg);
+	void *arg2;
+	double num;
+	double num2;
+};
+
+struct _shared_t {
+	op_t **ops;
+	unsigned len;
+	unsigned count;		/* number of occurrences */
+	insn_t *insns;
+	uint64_t update_count;
+	double num;
+};
+
 /******************************************************************************/
 
+/* string stack elements borrow loaded strings, which modules keep valid
+ * until the next update (see xsg_module_t in xsysguard.h), ops changing a
+ * string copy it into the element's own buffer first */
+typedef struct _str_t {
+	const char *str;	/* borrowed or inside buf */
+	xsg_string_t *buf;
+} str_t;
+
+/* vector stack elements always own their values, so the element-wise
+ * ops can work in place */
+typedef struct _vec_t {
+	double *num;
+	unsigned len;
+	unsigned size;
+} vec_t;
+
 static double *num_stack = NULL;
-static xsg_string_t **str_stack = NULL;
+static str_t *str_stack = NULL;
+static vec_t *vec_stack = NULL;
 
 static unsigned stack_index;
 static unsigned max_stack_size = 0;
 
+static xsg_hash_table_t *cache_table = NULL;	/* arg -> list of cache_t */
+static xsg_hash_table_t *shared_table = NULL;	/* key -> shared_t */
+static xsg_list_t *vector_list = NULL;		/* vector_t */
+
+/* parsed, but not yet compiled */
+static xsg_list_t *pending_list = NULL;
+
+/* stack effect of the op currently parsed */
+static unsigned popped;
+static unsigned pushed;
+
 /******************************************************************************/
 
-static heap_t *
-find_heap(xsg_rpn_t *rpn, uint32_t id)
-{
-	xsg_list_t *l;
-	heap_t *heap;
+static heap_file_t global_heap_file = { NULL, NULL, 0 };
 
-	for (l = rpn->heap_list; l; l = l->next) {
-		heap = l->data;
+static unsigned
+find_heap(heap_file_t *file, uint32_t id)
+{
+	unsigned slot;
 
-		if (heap->id == id) {
-			return heap;
+	for (slot = 0; slot < file->len; slot++) {
+		if (file->ids[slot] == id) {
+			return slot;
 		}
 	}
 
-	heap = xsg_new(heap_t, 1);
+	file->ids = xsg_renew(uint32_t, file->ids, file->len + 1);
+	file->heaps = xsg_renew(heap_t, file->heaps, file->len + 1);
+
+	file->ids[slot] = id;
+	file->heaps[slot].num = DNAN;
+	file->heaps[slot].str = xsg_string_new(NULL);
+
+	file->len++;
 
-	heap->id = id;
-	heap->num = DNAN;
-	heap->str = xsg_string_new(NULL);
+	return slot;
+}
+
+/* heap files grow while parsing, so ops get their heap pointers after all
+ * expressions have been parsed */
+static void
+resolve_heaps(xsg_rpn_t *rpn)
+{
+	xsg_list_t *l;
 
-	rpn->heap_list = xsg_list_prepend(rpn->heap_list, (void *) heap);
+	for (l = rpn->op_list; l; l = l->next) {
+		op_t *op = (op_t *) l->data;
 
-	return heap;
+		if (op->heap_file != NULL) {
+			op->arg = (void *) &op->heap_file->heaps[op->slot];
+		}
+	}
 }
 
 static double
@@ -105,6 +257,237 @@ load_string(void *arg)
 
 /******************************************************************************/
 
+static cache_t *
+find_cache(double (*num)(void *), const char *(*str)(void *), void *arg)
+{
+	xsg_list_t *l;
+
+	if (cache_table == NULL) {
+		return NULL;
+	}
+
+	l = xsg_hash_table_lookup(cache_table, arg);
+
+	for (; l; l = l->next) {
+		cache_t *cache = l->data;
+
+		if (cache->num_load == num && cache->str_load == str) {
+			return cache;
+		}
+	}
+
+	return NULL;
+}
+
+static cache_t *
+new_cache(double (*num)(void *), const char *(*str)(void *), void *arg)
+{
+	xsg_list_t *list;
+	cache_t *cache;
+
+	cache = find_cache(num, str, arg);
+
+	if (cache != NULL) {
+		return cache;
+	}
+
+	if (cache_table == NULL) {
+		cache_table = xsg_hash_table_new(xsg_direct_hash,
+				xsg_direct_equal);
+	}
+
+	cache = xsg_new(cache_t, 1);
+
+	cache->num_load = num;
+	cache->str_load = str;
+	cache->arg = arg;
+	cache->num_count = (uint64_t) -1;
+	cache->str_count = (uint64_t) -1;
+	cache->num = DNAN;
+	cache->str = NULL;
+	cache->constant = FALSE;
+	cache->version = 0;
+	cache->seen = NULL;
+
+	list = xsg_hash_table_lookup(cache_table, arg);
+	list = xsg_list_prepend(list, cache);
+	xsg_hash_table_insert(cache_table, arg, list);
+
+	return cache;
+}
+
+void
+xsg_rpn_set_pure(double (*num)(void *), const char *(*str)(void *), void *arg)
+{
+	if (num == NULL && str == NULL) {
+		return;
+	}
+
+	new_cache(num, str, arg);
+}
+
+void
+xsg_rpn_set_static(double (*num)(void *), const char *(*str)(void *), void *arg)
+{
+	if (num == NULL && str == NULL) {
+		return;
+	}
+
+	new_cache(num, str, arg)->constant = TRUE;
+}
+
+static double
+load_cached_number(void *arg)
+{
+	cache_t *cache = (cache_t *) arg;
+	uint64_t count = xsg_main_get_update_count();
+
+	if (cache->num_count != count) {
+		double num = cache->num_load(cache->arg);
+
+		if (num != cache->num && !(isnan(num) && isnan(cache->num))) {
+			cache->version++;
+		}
+		cache->num = num;
+		cache->num_count = count;
+	}
+
+	return cache->num;
+}
+
+static const char *
+load_cached_string(void *arg)
+{
+	cache_t *cache = (cache_t *) arg;
+	uint64_t count = xsg_main_get_update_count();
+
+	if (cache->str_count != count) {
+		cache->str = cache->str_load(cache->arg);
+		cache->str_count = count;
+
+		if (cache->seen != NULL) {
+			const char *str = cache->str ? cache->str : "";
+
+			if (strcmp(str, cache->seen->str) != 0) {
+				xsg_string_assign(cache->seen, str);
+				cache->version++;
+			}
+		}
+	}
+
+	return cache->str;
+}
+
+/******************************************************************************/
+
+static vector_t *
+find_vector(double (*num)(void *), void *arg)
+{
+	xsg_list_t *l;
+
+	for (l = vector_list; l; l = l->next) {
+		vector_t *vector = l->data;
+
+		if (vector->num_load == num && vector->arg == arg) {
+			return vector;
+		}
+	}
+
+	return NULL;
+}
+
+void
+xsg_rpn_set_vector(
+	double (*num)(void *),
+	void *arg,
+	const double *(*vec)(void *, unsigned *)
+)
+{
+	vector_t *vector;
+
+	if (num == NULL || vec == NULL) {
+		return;
+	}
+
+	/* shared sources are parsed more than once */
+	if (find_vector(num, arg) != NULL) {
+		return;
+	}
+
+	vector = xsg_new(vector_t, 1);
+
+	vector->num_load = num;
+	vector->arg = arg;
+	vector->vec_load = vec;
+
+	vector_list = xsg_list_prepend(vector_list, vector);
+}
+
+/******************************************************************************/
+
+static double *
+resize_vector(unsigned i, unsigned len)
+{
+	vec_t *v = &vec_stack[i];
+
+	if (unlikely(len > v->size)) {
+		v->num = xsg_renew(double, v->num, len);
+		v->size = len;
+	}
+
+	v->len = len;
+
+	return v->num;
+}
+
+static void
+load_vector(unsigned i, const double *values, unsigned len)
+{
+	double *num = resize_vector(i, len);
+
+	if (len > 0) {
+		memcpy(num, values, sizeof(double) * len);
+	}
+}
+
+/******************************************************************************/
+
+static void
+borrow_string(unsigned i, const char *str)
+{
+	str_stack[i].str = (str != NULL) ? str : "";
+}
+
+static void
+copy_string(unsigned i, const char *str)
+{
+	xsg_string_assign(str_stack[i].buf, (str != NULL) ? str : "");
+	str_stack[i].str = str_stack[i].buf->str;
+}
+
+static xsg_string_t *
+own_string(unsigned i)
+{
+	str_t *s = &str_stack[i];
+	xsg_string_t *buf = s->buf;
+
+	if (s->str == buf->str) {
+		return buf;
+	}
+
+	if (s->str > buf->str && s->str <= buf->str + buf->len) {
+		xsg_string_erase(buf, 0, s->str - buf->str);
+	} else {
+		xsg_string_assign(buf, s->str);
+	}
+
+	s->str = buf->str;
+
+	return buf;
+}
+
+/******************************************************************************/
+
 static void
 op_not(void)
 {
@@ -249,7 +632,7 @@ op_isinfone(void)
 
 static void
 op_if(void){
-	xsg_string_t *str_tmp;
+	str_t str_tmp;
 	unsigned idx;
 
 	idx = num_stack[stack_index - 2] != 0.0
@@ -264,7 +647,7 @@ op_if(void){
 static void
 op_if_str(void)
 {
-	xsg_string_t *str_tmp;
+	str_t str_tmp;
 	unsigned idx;
 
 	idx = num_stack[stack_index - 2] != 0.0
@@ -497,27 +880,31 @@ op_abs(void)
 }
 
 static void
-op_dup(void)
+op_dup_num(void)
 {
 	num_stack[stack_index + 1] = num_stack[stack_index];
-	xsg_string_assign(str_stack[stack_index + 1],
-			str_stack[stack_index]->str);
 	stack_index += 1;
 }
 
 static void
-op_dup_num(void)
+op_dup_str(void)
 {
-	num_stack[stack_index + 1] = num_stack[stack_index];
+	str_t *s = &str_stack[stack_index];
+
+	/* never borrow from another element's buffer */
+	if (s->str >= s->buf->str && s->str <= s->buf->str + s->buf->len) {
+		copy_string(stack_index + 1, s->str);
+	} else {
+		borrow_string(stack_index + 1, s->str);
+	}
 	stack_index += 1;
 }
 
 static void
-op_dup_str(void)
+op_dup(void)
 {
-	xsg_string_assign(str_stack[stack_index + 1],
-			str_stack[stack_index]->str);
-	stack_index += 1;
+	num_stack[stack_index + 1] = num_stack[stack_index];
+	op_dup_str();
 }
 
 static void
@@ -541,7 +928,7 @@ op_exc_nn(void)
 static void
 op_exc_ss(void)
 {
-	xsg_string_t *str_tmp;
+	str_t str_tmp;
 
 	str_tmp = str_stack[stack_index];
 	str_stack[stack_index] = str_stack[stack_index - 1];
@@ -551,7 +938,7 @@ op_exc_ss(void)
 static void
 op_exc(void)
 {
-	xsg_string_t *str_tmp;
+	str_t str_tmp;
 	double num_tmp;
 
 	str_tmp = str_stack[stack_index];
@@ -570,7 +957,7 @@ op_atof(void)
 {
 	double num;
 
-	num = atof(str_stack[stack_index]->str);
+	num = atof(str_stack[stack_index].str);
 	num_stack[stack_index] = num;
 }
 
@@ -579,7 +966,7 @@ op_atoi(void)
 {
 	int num;
 
-	num = atoi(str_stack[stack_index]->str);
+	num = atoi(str_stack[stack_index].str);
 	num_stack[stack_index] = num;
 }
 
@@ -588,7 +975,7 @@ op_atol(void)
 {
 	long int num;
 
-	num = atol(str_stack[stack_index]->str);
+	num = atol(str_stack[stack_index].str);
 	num_stack[stack_index] = num;
 }
 
@@ -597,103 +984,110 @@ op_atoll(void)
 {
 	long long int num;
 
-	num = atoll(str_stack[stack_index]->str);
+	num = atoll(str_stack[stack_index].str);
 	num_stack[stack_index] = num;
 }
 
 static void
 op_strtof(void)
 {
-	char *nptr, *endptr;
+	const char *nptr;
+	char *endptr;
 	float num;
 
-	nptr = str_stack[stack_index]->str;
+	nptr = str_stack[stack_index].str;
 	num = strtof(nptr, &endptr);
 	num_stack[stack_index] = num;
-	xsg_string_erase(str_stack[stack_index], 0, endptr - nptr);
+	str_stack[stack_index].str = endptr;
 }
 
 static void
 op_strtod(void)
 {
-	char *nptr, *endptr;
+	const char *nptr;
+	char *endptr;
 	double num;
 
-	nptr = str_stack[stack_index]->str;
+	nptr = str_stack[stack_index].str;
 	num = strtod(nptr, &endptr);
 	num_stack[stack_index] = num;
-	xsg_string_erase(str_stack[stack_index], 0, endptr - nptr);
+	str_stack[stack_index].str = endptr;
 }
 
 static void
 op_strtold(void)
 {
-	char *nptr, *endptr;
+	const char *nptr;
+	char *endptr;
 	long double num;
 
-	nptr = str_stack[stack_index]->str;
+	nptr = str_stack[stack_index].str;
 	num = strtold(nptr, &endptr);
 	num_stack[stack_index] = num;
-	xsg_string_erase(str_stack[stack_index], 0, endptr - nptr);
+	str_stack[stack_index].str = endptr;
 }
 
 static void
 op_strtol(void)
 {
-	char *nptr, *endptr;
+	const char *nptr;
+	char *endptr;
 	long int num;
 	int base;
 
-	nptr = str_stack[stack_index - 1]->str;
+	nptr = str_stack[stack_index - 1].str;
 	base = (int) num_stack[stack_index];
 	num = strtol(nptr, &endptr, base);
 	num_stack[stack_index - 1] = num;
-	xsg_string_erase(str_stack[stack_index - 1], 0, endptr - nptr);
+	str_stack[stack_index - 1].str = endptr;
 	stack_index -= 1;
 }
 
 static void
 op_strtoll(void)
 {
-	char *nptr, *endptr;
+	const char *nptr;
+	char *endptr;
 	long long int num;
 	int base;
 
-	nptr = str_stack[stack_index - 1]->str;
+	nptr = str_stack[stack_index - 1].str;
 	base = (int) num_stack[stack_index];
 	num = strtoll(nptr, &endptr, base);
 	num_stack[stack_index - 1] = num;
-	xsg_string_erase(str_stack[stack_index - 1], 0, endptr - nptr);
+	str_stack[stack_index - 1].str = endptr;
 	stack_index -= 1;
 }
 
 static void
 op_strtoul(void)
 {
-	char *nptr, *endptr;
+	const char *nptr;
+	char *endptr;
 	unsigned long int num;
 	int base;
 
-	nptr = str_stack[stack_index - 1]->str;
+	nptr = str_stack[stack_index - 1].str;
 	base = (int) num_stack[stack_index];
 	num = strtoul(nptr, &endptr, base);
 	num_stack[stack_index - 1] = num;
-	xsg_string_erase(str_stack[stack_index - 1], 0, endptr - nptr);
+	str_stack[stack_index - 1].str = endptr;
 	stack_index -= 1;
 }
 
 static void
 op_strtoull(void)
 {
-	char *nptr, *endptr;
+	const char *nptr;
+	char *endptr;
 	unsigned long long int num;
 	int base;
 
-	nptr = str_stack[stack_index - 1]->str;
+	nptr = str_stack[stack_index - 1].str;
 	base = (int) num_stack[stack_index];
 	num = strtoull(nptr, &endptr, base);
 	num_stack[stack_index - 1] = num;
-	xsg_string_erase(str_stack[stack_index - 1], 0, endptr - nptr);
+	str_stack[stack_index - 1].str = endptr;
 	stack_index -= 1;
 }
 
@@ -702,15 +1096,15 @@ op_strtoull(void)
 static void
 op_strlen(void)
 {
-	num_stack[stack_index] = (double) str_stack[stack_index]->len;
+	num_stack[stack_index] = (double) strlen(str_stack[stack_index].str);
 }
 
 static void
 op_strcmp(void)
 {
 	num_stack[stack_index - 1] = (double) strcmp(
-			str_stack[stack_index - 1]->str,
-			str_stack[stack_index]->str);
+			str_stack[stack_index - 1].str,
+			str_stack[stack_index].str);
 	stack_index -= 1;
 }
 
@@ -718,30 +1112,32 @@ static void
 op_strcasecmp(void)
 {
 	num_stack[stack_index - 1] = (double) strcasecmp(
-			str_stack[stack_index - 1]->str,
-			str_stack[stack_index]->str);
+			str_stack[stack_index - 1].str,
+			str_stack[stack_index].str);
 	stack_index -= 1;
 }
 
 static void
 op_strup(void)
 {
-	xsg_string_up(str_stack[stack_index]);
+	xsg_string_up(own_string(stack_index));
 }
 
 static void
 op_strdown(void)
 {
-	xsg_string_down(str_stack[stack_index]);
+	xsg_string_down(own_string(stack_index));
 }
 
 static void
 op_strreverse(void)
 {
+	xsg_string_t *string;
 	char *h, *t;
 
-	h = str_stack[stack_index]->str;
-	t = h + str_stack[stack_index]->len - 1;
+	string = own_string(stack_index);
+	h = string->str;
+	t = h + string->len - 1;
 
 	if (*h) {
 		while (h < t) {
@@ -759,29 +1155,27 @@ op_strreverse(void)
 static void
 op_strchug(void)
 {
-	char *string;
-	size_t len;
+	const char *string;
 
-	string = str_stack[stack_index]->str;
+	string = str_stack[stack_index].str;
 
 	while (*string && isspace((unsigned char) *string)) {
 		string++;
 	}
 
-	len = strlen(string);
-
-	str_stack[stack_index]->len = len;
-	memmove(str_stack[stack_index]->str, string, len + 1);
+	str_stack[stack_index].str = string;
 }
 
 static void
 op_strchomp(void)
 {
+	xsg_string_t *buf;
 	char *string;
 	size_t len;
 
-	string = str_stack[stack_index]->str;
-	len = str_stack[stack_index]->len;
+	buf = own_string(stack_index);
+	string = buf->str;
+	len = buf->len;
 
 	while (len--) {
 		if (isspace((unsigned char) string[len])) {
@@ -791,7 +1185,7 @@ op_strchomp(void)
 		}
 	}
 
-	str_stack[stack_index]->len = len + 1;
+	buf->len = len + 1;
 }
 
 static void
@@ -800,443 +1194,2044 @@ op_strtruncate(void)
 	size_t len;
 
 	len = num_stack[stack_index];
-	xsg_string_truncate(str_stack[stack_index - 1], len);
+	xsg_string_truncate(own_string(stack_index - 1), len);
 	stack_index -= 1;
 }
 
 /******************************************************************************/
 
-static double
-get_number(void *arg)
-{
-	return *(double *) arg;
+/* time-series ops, they keep their previous samples in a fixed state */
+
+typedef struct _delta_t {
+	double prev;
+	uint64_t time;		/* monotonic ns of prev, 0 if none */
+} delta_t;
+
+typedef struct _ewma_t {
+	double alpha;
+	double avg;
+} ewma_t;
+
+typedef struct _window_t {
+	unsigned size;		/* number of samples */
+	unsigned count;		/* samples in the ring */
+	unsigned pos;		/* next position in the ring */
+	double *ring;
+	double sum;		/* WINAVG: sum of all non-NAN samples */
+	unsigned valid;		/* WINAVG: number of non-NAN samples */
+	bool max;		/* WINMAX */
+	uint64_t index;		/* WINMIN, WINMAX: number of samples */
+	uint64_t *deque;	/* WINMIN, WINMAX: monotonic sample indices */
+	unsigned head;
+	unsigned len;
+} window_t;
+
+static uint64_t
+monotonic_time(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+		return 0;
+	}
+
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
 }
 
-static const char *
-get_string(void *arg)
+static delta_t *
+new_delta(void)
 {
-	return (char *) arg;
+	delta_t *delta = xsg_new(delta_t, 1);
+
+	delta->prev = DNAN;
+	delta->time = 0;
+
+	return delta;
 }
 
-/******************************************************************************/
+static void
+op_delta(void *arg)
+{
+	delta_t *delta = (delta_t *) arg;
+	double num = num_stack[stack_index];
 
-static bool
-pop(xsg_string_t *stack, const char *str)
+	num_stack[stack_index] = num - delta->prev;
+	delta->prev = num;
+}
+
+static void
+op_rate(void *arg)
 {
-	size_t len, i;
+	delta_t *delta = (delta_t *) arg;
+	double num = num_stack[stack_index];
+	double diff = num - delta->prev;
+	uint64_t now = monotonic_time();
 
-	len = strlen(str);
+	/* a 32 bit counter wrapped around if it was in the upper and is now
+	 * in the lower half of its range, any other decrease is a reset or
+	 * a gauge and has no meaningful rate */
+	if (diff < 0.0) {
+		if (delta->prev < 4294967296.0 && delta->prev >= 2147483648.0
+				&& num >= 0.0 && num < 2147483648.0) {
+			diff += 4294967296.0;
+		} else {
+			diff = DNAN;
+		}
+	}
 
-	if (stack->len < len) {
-		return FALSE;
+	if (delta->time != 0 && now > delta->time) {
+		num_stack[stack_index] = diff * 1e9 / (double) (now - delta->time);
+	} else {
+		num_stack[stack_index] = DNAN;
 	}
 
-	for (i = 1; i <= len; i++) {
-		char c1, c2;
+	delta->prev = num;
+	delta->time = now;
+}
 
-		c1 = stack->str[stack->len - i];
-		c2 = str[len - i];
+static void
+op_ewma(void *arg)
+{
+	ewma_t *ewma = (ewma_t *) arg;
+	double num = num_stack[stack_index];
 
-		if (c1 != c2 && c1 != 'X') {
-			return FALSE;
-		}
+	if (isnan(num)) {
+		;
+	} else if (isnan(ewma->avg)) {
+		ewma->avg = num;
+	} else {
+		ewma->avg += ewma->alpha * (num - ewma->avg);
 	}
 
-	stack->len -= len;
-	stack->str[stack->len] = 0;
+	num_stack[stack_index] = ewma->avg;
+}
 
-	return TRUE;
+static window_t *
+new_window(unsigned size, bool max)
+{
+	window_t *window = xsg_new(window_t, 1);
+
+	window->size = size;
+	window->count = 0;
+	window->pos = 0;
+	window->ring = xsg_new(double, size);
+	window->sum = 0.0;
+	window->valid = 0;
+	window->max = max;
+	window->index = 0;
+	window->deque = xsg_new(uint64_t, size);
+	window->head = 0;
+	window->len = 0;
+
+	return window;
 }
 
-/******************************************************************************/
+static void
+op_winavg(void *arg)
+{
+	window_t *window = (window_t *) arg;
+	double num = num_stack[stack_index];
 
-#define PUSH(s) xsg_string_append(rpn->stack, s)
-#define POP(s, log) \
-	if (!pop(rpn->stack, s)) { \
-		xsg_conf_error("RPN: %s: stack was '%s', but '%s' expected", \
-				log, rpn->stack->str, s); \
+	if (window->count == window->size) {
+		double old = window->ring[window->pos];
+
+		if (!isnan(old)) {
+			window->sum -= old;
+			window->valid--;
+		}
+	} else {
+		window->count++;
 	}
 
-static xsg_rpn_t *
-parse(uint64_t update, xsg_var_t *var)
-{
-	xsg_rpn_t *rpn;
+	window->ring[window->pos] = num;
 
-	rpn = xsg_new(xsg_rpn_t, 1);
+	if (!isnan(num)) {
+		window->sum += num;
+		window->valid++;
+	}
 
-	rpn->op_list = NULL;
-	rpn->stack = xsg_string_new(NULL);
-	rpn->heap_list = NULL;
+	window->pos = (window->pos + 1) % window->size;
 
-	do {
-		double number;
-		char *string;
-		op_t *op;
+	/* recompute the sum once per window to get rid of rounding errors */
+	if (window->pos == 0) {
+		unsigned i;
 
-		op = xsg_new0(op_t, 1);
+		window->sum = 0.0;
 
-		if (xsg_conf_find_number(&number)) {
-			double *numberp = xsg_new(double, 1);
-			*numberp = number;
-			op->num_load = get_number;
-			op->arg = (void *) numberp;
-			PUSH("N");
-		} else if (xsg_conf_find_string(&string)) {
-			op->str_load = get_string;
-			op->arg = (void *) string;
-			PUSH("S");
-		} else if (xsg_conf_find_command("LOAD")) {
-			heap_t *heap = find_heap(rpn, xsg_conf_read_uint());
-			op->num_load = load_number;
-			op->str_load = load_string;
-			op->arg = (void *) heap;
-			PUSH("X");
-		} else if (xsg_conf_find_command("STORE")) {
-			heap_t *heap = find_heap(rpn, xsg_conf_read_uint());
-			/* NOTE: "NX" needs to be first!
-			 * ("NN" and "NS" will match "NX" too) */
-			if (pop(rpn->stack, "NX")) {
-				op->store = 'X';
-			} else if (pop(rpn->stack, "NN")) {
-				op->store = 'N';
-			} else if (pop(rpn->stack, "NS")) {
-				op->store = 'S';
-			} else {
-				xsg_conf_error("RPN: STORE: stack was '%s', "
-						"but 'NN' or 'NS' expected",
-						rpn->stack->str);
+		for (i = 0; i < window->count; i++) {
+			if (!isnan(window->ring[i])) {
+				window->sum += window->ring[i];
 			}
-			op->arg = (void *) heap;
-		} else if (xsg_conf_find_command("NOT")) {
-			POP("N", "NOT");
-			op->op = op_not;
-			PUSH("N");
-		} else if (xsg_conf_find_command("LT")) {
-			POP("NN", "LT");
-			op->op = op_lt;
-			PUSH("N");
-		} else if (xsg_conf_find_command("LE")) {
-			POP("NN", "LE");
-			op->op = op_le;
-			PUSH("N");
-		} else if (xsg_conf_find_command("GT")) {
-			POP("NN", "GT");
-			op->op = op_gt;
-			PUSH("N");
-		} else if (xsg_conf_find_command("GE")) {
-			POP("NN", "GE");
-			op->op = op_ge;
-			PUSH("N");
-		} else if (xsg_conf_find_command("EQ")) {
-			POP("NN", "EQ");
-			op->op = op_eq;
-			PUSH("N");
-		} else if (xsg_conf_find_command("NE")) {
-			POP("NN", "NE");
-			op->op = op_ne;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ISNAN")) {
-			POP("N", "ISNAN");
-			op->op = op_isnan;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ISINF")) {
-			POP("N", "ISINF");
-			op->op = op_isinf;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ISNANZERO")) {
-			POP("N", "ISNANZERO");
-			op->op = op_isnanzero;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ISINFZERO")) {
-			POP("N", "ISINFZERO");
-			op->op = op_isinfzero;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ISNANONE")) {
-			POP("N", "ISNANONE");
-			op->op = op_isnanone;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ISINFONE")) {
-			POP("N", "ISINFONE");
-			op->op = op_isinfone;
-			PUSH("N");
-		} else if (xsg_conf_find_command("IF")) {
-			/* NOTE: "NXX" needs to be first!
-			 * ("NNN" and "NSS" will match "NXX" too) */
-			if (pop(rpn->stack, "NXX")) {
-				op->op = op_if;
-				PUSH("X");
-			} else if (pop(rpn->stack, "NNN")) {
-				op->op = op_if_num;
-				PUSH("N");
-			} else if (pop(rpn->stack, "NSS")) {
-				op->op = op_if_str;
-				PUSH("S");
+		}
+	}
+
+	if (window->valid == 0) {
+		num_stack[stack_index] = DNAN;
+	} else {
+		num_stack[stack_index] = window->sum / window->valid;
+	}
+}
+
+static void
+op_winminmax(void *arg)
+{
+	window_t *window = (window_t *) arg;
+	double num = num_stack[stack_index];
+	uint64_t index = window->index++;
+	unsigned size = window->size;
+
+	/* remove the sample leaving the window */
+	if (window->len > 0 && window->deque[window->head] + size <= index) {
+		window->head = (window->head + 1) % size;
+		window->len--;
+	}
+
+	window->ring[index % size] = num;
+
+	if (!isnan(num)) {
+		/* drop samples that can never become the minimum (maximum) */
+		while (window->len > 0) {
+			unsigned tail = (window->head + window->len - 1) % size;
+			double prev = window->ring[window->deque[tail] % size];
+
+			if (window->max ? prev > num : prev < num) {
+				break;
+			}
+
+			window->len--;
+		}
+
+		window->deque[(window->head + window->len) % size] = index;
+		window->len++;
+	}
+
+	if (window->len == 0) {
+		num_stack[stack_index] = DNAN;
+	} else {
+		num_stack[stack_index] = window->ring[
+				window->deque[window->head] % size];
+	}
+}
+
+/******************************************************************************/
+
+/* vector ops, the element-wise loops run over plain double arrays and
+ * can be vectorized by the compiler */
+
+static void
+op_vadd_vv(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	vec_t *w = &vec_stack[stack_index];
+	double *a = v->num;
+	const double *b = w->num;
+	unsigned len = MIN(v->len, w->len);
+	unsigned i;
+
+	for (i = 0; i < len; i++) {
+		a[i] += b[i];
+	}
+
+	v->len = len;
+	stack_index -= 1;
+}
+
+static void
+op_vsub_vv(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	vec_t *w = &vec_stack[stack_index];
+	double *a = v->num;
+	const double *b = w->num;
+	unsigned len = MIN(v->len, w->len);
+	unsigned i;
+
+	for (i = 0; i < len; i++) {
+		a[i] -= b[i];
+	}
+
+	v->len = len;
+	stack_index -= 1;
+}
+
+static void
+op_vmul_vv(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	vec_t *w = &vec_stack[stack_index];
+	double *a = v->num;
+	const double *b = w->num;
+	unsigned len = MIN(v->len, w->len);
+	unsigned i;
+
+	for (i = 0; i < len; i++) {
+		a[i] *= b[i];
+	}
+
+	v->len = len;
+	stack_index -= 1;
+}
+
+static void
+op_vdiv_vv(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	vec_t *w = &vec_stack[stack_index];
+	double *a = v->num;
+	const double *b = w->num;
+	unsigned len = MIN(v->len, w->len);
+	unsigned i;
+
+	for (i = 0; i < len; i++) {
+		a[i] /= b[i];
+	}
+
+	v->len = len;
+	stack_index -= 1;
+}
+
+static void
+op_vadd_vn(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	double *a = v->num;
+	double n = num_stack[stack_index];
+	unsigned i;
+
+	for (i = 0; i < v->len; i++) {
+		a[i] += n;
+	}
+
+	stack_index -= 1;
+}
+
+static void
+op_vsub_vn(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	double *a = v->num;
+	double n = num_stack[stack_index];
+	unsigned i;
+
+	for (i = 0; i < v->len; i++) {
+		a[i] -= n;
+	}
+
+	stack_index -= 1;
+}
+
+static void
+op_vmul_vn(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	double *a = v->num;
+	double n = num_stack[stack_index];
+	unsigned i;
+
+	for (i = 0; i < v->len; i++) {
+		a[i] *= n;
+	}
+
+	stack_index -= 1;
+}
+
+static void
+op_vdiv_vn(void)
+{
+	vec_t *v = &vec_stack[stack_index - 1];
+	double *a = v->num;
+	double n = num_stack[stack_index];
+	unsigned i;
+
+	for (i = 0; i < v->len; i++) {
+		a[i] /= n;
+	}
+
+	stack_index -= 1;
+}
+
+static void
+op_vsum(void)
+{
+	vec_t *v = &vec_stack[stack_index];
+	const double *a = v->num;
+	double sum = 0.0;
+	unsigned i;
+
+	for (i = 0; i < v->len; i++) {
+		sum += a[i];
+	}
+
+	num_stack[stack_index] = sum;
+}
+
+static void
+op_vavg(void)
+{
+	vec_t *v = &vec_stack[stack_index];
+	const double *a = v->num;
+	double sum = 0.0;
+	unsigned i;
+
+	for (i = 0; i < v->len; i++) {
+		sum += a[i];
+	}
+
+	if (v->len == 0) {
+		num_stack[stack_index] = DNAN;
+	} else {
+		num_stack[stack_index] = sum / v->len;
+	}
+}
+
+static void
+op_vmin(void)
+{
+	vec_t *v = &vec_stack[stack_index];
+	const double *a = v->num;
+	double min = DNAN;
+	unsigned i;
+
+	if (v->len > 0) {
+		min = a[0];
+	}
+
+	for (i = 1; i < v->len; i++) {
+		min = MIN(min, a[i]);
+	}
+
+	num_stack[stack_index] = min;
+}
+
+static void
+op_vmax(void)
+{
+	vec_t *v = &vec_stack[stack_index];
+	const double *a = v->num;
+	double max = DNAN;
+	unsigned i;
+
+	if (v->len > 0) {
+		max = a[0];
+	}
+
+	for (i = 1; i < v->len; i++) {
+		max = MAX(max, a[i]);
+	}
+
+	num_stack[stack_index] = max;
+}
+
+static void
+op_vlen(void)
+{
+	num_stack[stack_index] = (double) vec_stack[stack_index].len;
+}
+
+static void
+op_vget(void *arg)
+{
+	vec_t *v = &vec_stack[stack_index];
+	unsigned index = *(unsigned *) arg;
+
+	if (index < v->len) {
+		num_stack[stack_index] = v->num[index];
+	} else {
+		num_stack[stack_index] = DNAN;
+	}
+}
+
+static void
+op_vdelta(void *arg)
+{
+	vec_t *prev = (vec_t *) arg;
+	vec_t *v = &vec_stack[stack_index];
+	double *a = v->num;
+	double *b;
+	unsigned len = MIN(prev->len, v->len);
+	unsigned i;
+
+	if (prev->size < v->len) {
+		prev->num = xsg_renew(double, prev->num, v->len);
+		prev->size = v->len;
+	}
+
+	b = prev->num;
+
+	for (i = 0; i < len; i++) {
+		double num = a[i];
+
+		a[i] = num - b[i];
+		b[i] = num;
+	}
+
+	/* new elements have no previous value yet */
+	for (; i < v->len; i++) {
+		b[i] = a[i];
+		a[i] = DNAN;
+	}
+
+	prev->len = v->len;
+}
+
+static void
+op_dup_vec(void)
+{
+	vec_t *v = &vec_stack[stack_index];
+
+	load_vector(stack_index + 1, v->num, v->len);
+	stack_index += 1;
+}
+
+static void
+op_exc_vec(void)
+{
+	vec_t vec_tmp;
+
+	vec_tmp = vec_stack[stack_index];
+	vec_stack[stack_index] = vec_stack[stack_index - 1];
+	vec_stack[stack_index - 1] = vec_tmp;
+
+	op_exc();
+}
+
+/******************************************************************************/
+
+static double
+get_number(void *arg)
+{
+	return *(double *) arg;
+}
+
+static const char *
+get_string(void *arg)
+{
+	return (char *) arg;
+}
+
+/******************************************************************************/
+
+static bool
+pop(xsg_string_t *stack, const char *str)
+{
+	size_t len, i;
+
+	len = strlen(str);
+
+	if (stack->len < len) {
+		return FALSE;
+	}
+
+	for (i = 1; i <= len; i++) {
+		char c1, c2;
+
+		c1 = stack->str[stack->len - i];
+		c2 = str[len - i];
+
+		if (c1 != c2 && c1 != 'X') {
+			return FALSE;
+		}
+	}
+
+	stack->len -= len;
+	stack->str[stack->len] = 0;
+
+	popped += len;
+
+	return TRUE;
+}
+
+/******************************************************************************/
+
+static double
+load_shared_number(void *arg)
+{
+	shared_t *shared = (shared_t *) arg;
+
+	return shared->num;
+}
+
+static bool
+is_num_load(op_t *op)
+{
+	return op->op == NULL && op->store == '\0'
+			&& op->num_load != NULL && op->str_load == NULL
+			&& op->num_load != load_shared_number;
+}
+
+static bool
+is_const(op_t *op)
+{
+	return is_num_load(op) && op->num_load == get_number;
+}
+
+static unsigned
+arith_code(op_t *op)
+{
+	if (op->op == op_add) {
+		return INSN_ADD;
+	} else if (op->op == op_sub) {
+		return INSN_SUB;
+	} else if (op->op == op_mul) {
+		return INSN_MUL;
+	} else if (op->op == op_div) {
+		return INSN_DIV;
+	} else {
+		return INSN_END;
+	}
+}
+
+static insn_t *
+compile(op_t **op_array, unsigned n)
+{
+	op_t **ops;
+	insn_t *insns, *insn;
+	unsigned i;
+
+	ops = alloca(sizeof(op_t *) * (n + 4));
+
+	for (i = 0; i < n; i++) {
+		ops[i] = op_array[i];
+	}
+
+	/* sentinels for the pattern matching below */
+	for (i = n; i < n + 4; i++) {
+		ops[i] = NULL;
+	}
+
+	insns = insn = xsg_new0(insn_t, n + 1);
+
+	i = 0;
+
+	while (i < n) {
+		op_t *op = ops[i];
+		unsigned code;
+
+		if (is_num_load(op) && ops[i + 1] && is_num_load(ops[i + 1])
+				&& ops[i + 2] && ops[i + 2]->op == op_div) {
+			insn->num_load = op->num_load;
+			insn->arg = op->arg;
+			insn->num_load2 = ops[i + 1]->num_load;
+			insn->arg2 = ops[i + 1]->arg;
+			if (ops[i + 3] && is_const(ops[i + 3])
+					&& ops[i + 4] && ops[i + 4]->op == op_mul) {
+				insn->code = INSN_LOAD_LOAD_DIV_MUL;
+				insn->num = *(double *) ops[i + 3]->arg;
+				i += 5;
 			} else {
-				xsg_conf_error("RPN: IF: stack was '%s', but "
-						"'NNN' or 'NSS' expected",
-						rpn->stack->str);
+				insn->code = INSN_LOAD_LOAD_DIV;
+				i += 3;
 			}
-		} else if (xsg_conf_find_command("MIN")) {
-			POP("NN", "MIN");
-			op->op = op_min;
-			PUSH("N");
-		} else if (xsg_conf_find_command("MAX")) {
-			POP("NN", "MAX");
-			op->op = op_max;
-			PUSH("N");
-		} else if (xsg_conf_find_command("LIMIT")) {
-			POP("NNN", "LIMIT");
-			op->op = op_limit;
-			PUSH("N");
-		} else if (xsg_conf_find_command("PI")) {
-			op->op = op_pi;
-			PUSH("N");
-		} else if (xsg_conf_find_command("NAN")) {
-			op->op = op_nan;
-			PUSH("N");
-		} else if (xsg_conf_find_command("INF")) {
-			op->op = op_inf;
-			PUSH("N");
-		} else if (xsg_conf_find_command("NEGINF")) {
-			op->op = op_neginf;
-			PUSH("N");
-		} else if (xsg_conf_find_command("NEG")) {
-			POP("N", "NEG");
-			op->op = op_neg;
-			PUSH("N");
-		} else if (xsg_conf_find_command("INC")) {
-			POP("N", "INC");
-			op->op = op_inc;
-			PUSH("N");
-		} else if (xsg_conf_find_command("DEC")) {
-			POP("N", "DEC");
-			op->op = op_dec;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ADD")) {
-			POP("NN", "ADD");
-			op->op = op_add;
-			PUSH("N");
-		} else if (xsg_conf_find_command("SUB")) {
-			POP("NN", "SUB");
-			op->op = op_sub;
-			PUSH("N");
-		} else if (xsg_conf_find_command("MUL")) {
-			POP("NN", "MUL");
-			op->op = op_mul;
-			PUSH("N");
-		} else if (xsg_conf_find_command("DIV")) {
-			POP("NN", "DIV");
-			op->op = op_div;
-			PUSH("N");
-		} else if (xsg_conf_find_command("MOD")) {
-			POP("NN", "MOD");
-			op->op = op_mod;
-			PUSH("N");
-		} else if (xsg_conf_find_command("SIN")) {
-			POP("N", "SIN");
-			op->op = op_sin;
-			PUSH("N");
-		} else if (xsg_conf_find_command("COS")) {
-			POP("N", "COS");
-			op->op = op_cos;
-			PUSH("N");
-		} else if (xsg_conf_find_command("LOG")) {
-			POP("N", "LOG");
-			op->op = op_log;
-			PUSH("N");
-		} else if (xsg_conf_find_command("EXP")) {
-			POP("N", "EXP");
-			op->op = op_exp;
-			PUSH("N");
-		} else if (xsg_conf_find_command("SQRT")) {
-			POP("N", "SQRT");
-			op->op = op_sqrt;
-			PUSH("N");
-		} else if (xsg_conf_find_command("POW")) {
-			POP("NN", "POW");
-			op->op = op_pow;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ATAN2")) {
-			POP("NN", "ATAN2");
-			op->op = op_atan2;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ATAN")) {
-			POP("N", "ATAN");
-			op->op = op_atan;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ROUND")) {
-			POP("N", "ROUND");
-			op->op = op_round;
-			PUSH("N");
-		} else if (xsg_conf_find_command("FLOOR")) {
-			POP("N", "FLOOR");
-			op->op = op_floor;
-			PUSH("N");
-		} else if (xsg_conf_find_command("CEIL")) {
-			POP("N", "CEIL");
-			op->op = op_ceil;
-			PUSH("N");
-		} else if (xsg_conf_find_command("DEG2RAD")) {
-			POP("N", "DEG2RAD");
-			op->op = op_deg2rad;
-			PUSH("N");
-		} else if (xsg_conf_find_command("RAD2DEG")) {
-			POP("N", "RAD2DEG");
-			op->op = op_rad2deg;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ABS")) {
-			POP("N", "ABS");
-			op->op = op_abs;
-			PUSH("N");
-		} else if (xsg_conf_find_command("DUP")) {
-			/* NOTE: "X" needs to be first!
-			 * ("N" and "S" will match "X" too) */
-			if (pop(rpn->stack, "X")) {
-				op->op = op_dup;
-				PUSH("XX");
-			} else if (pop(rpn->stack, "N")) {
-				op->op = op_dup_num;
-				PUSH("NN");
-			} else if (pop(rpn->stack, "S")) {
-				op->op = op_dup_str;
-				PUSH("SS");
+		} else if (is_const(op) && ops[i + 1] && is_const(ops[i + 1])
+				&& ops[i + 2] && ops[i + 2]->op == op_limit) {
+			insn->code = INSN_CONST_LIMIT;
+			insn->num = *(double *) op->arg;
+			insn->num2 = *(double *) ops[i + 1]->arg;
+			i += 3;
+		} else if (is_num_load(op) && ops[i + 1]
+				&& (code = arith_code(ops[i + 1])) != INSN_END) {
+			if (is_const(op)) {
+				insn->code = code - INSN_ADD + INSN_CONST_ADD;
+				insn->num = *(double *) op->arg;
 			} else {
-				xsg_conf_error("RPN: DUP: no element on the "
-						"stack");
+				insn->code = code - INSN_ADD + INSN_LOAD_ADD;
+				insn->num_load = op->num_load;
+				insn->arg = op->arg;
 			}
-		} else if (xsg_conf_find_command("POP")) {
-			if (pop(rpn->stack, "X")) {
-				op->op = op_pop;
-			} else if (pop(rpn->stack, "N")) {
-				op->op = op_pop;
-			} else if (pop(rpn->stack, "S")) {
-				op->op = op_pop;
+			i += 2;
+		} else if (op->op != NULL) {
+			if ((code = arith_code(op)) != INSN_END) {
+				insn->code = code;
+			} else if (op->op == op_limit) {
+				insn->code = INSN_LIMIT;
 			} else {
-				xsg_conf_error("RPN: POP: no element on the "
-						"stack");
+				insn->code = INSN_OP;
+				insn->op = op->op;
+			}
+			i += 1;
+		} else if (op->op_state != NULL) {
+			insn->code = INSN_OP_STATE;
+			insn->op_state = op->op_state;
+			insn->arg = op->arg;
+			i += 1;
+		} else if (is_const(op)) {
+			insn->code = INSN_CONST;
+			insn->num = *(double *) op->arg;
+			i += 1;
+		} else if (op->num_load == load_shared_number) {
+			insn->code = INSN_SHARED;
+			insn->arg = op->arg;
+			i += 1;
+		} else if (op->str_load == load_string) {
+			insn->code = INSN_LOAD_HEAP;
+			insn->arg = op->arg;
+			i += 1;
+		} else if (op->vec_load != NULL) {
+			insn->code = INSN_LOAD_VEC;
+			insn->vec_load = op->vec_load;
+			insn->arg = op->arg;
+			i += 1;
+		} else if (op->num_load || op->str_load) {
+			if (op->num_load && op->str_load) {
+				insn->code = INSN_LOAD_BOTH;
+			} else if (op->num_load) {
+				insn->code = INSN_LOAD_NUM;
+			} else {
+				insn->code = INSN_LOAD_STR;
+			}
+			insn->num_load = op->num_load;
+			insn->str_load = op->str_load;
+			insn->arg = op->arg;
+			i += 1;
+		} else {
+			insn->code = INSN_STORE;
+			insn->store = op->store;
+			insn->arg = op->arg;
+			i += 1;
+		}
+
+		insn++;
+	}
+
+	insn->code = INSN_END;
+
+	return insns;
+}
+
+/******************************************************************************/
+
+/* executes a single op, used to fold constant sub-expressions */
+
+static void
+exec(op_t *op)
+{
+	if (op->op) {
+		op->op();
+	} else if (op->op_state) {
+		op->op_state(op->arg);
+	} else if (op->vec_load) {
+		const double *values;
+		unsigned len = 0;
+
+		stack_index++;
+		values = op->vec_load(op->arg, &len);
+		load_vector(stack_index, values, len);
+	} else if (op->num_load || op->str_load) {
+		stack_index++;
+		if (op->num_load) {
+			num_stack[stack_index] = op->num_load(op->arg);
+		}
+		if (op->str_load == load_string) {
+			copy_string(stack_index, op->str_load(op->arg));
+		} else if (op->str_load) {
+			borrow_string(stack_index, op->str_load(op->arg));
+		}
+	} else if (op->store != '\0') {
+		heap_t *heap = (heap_t *) op->arg;
+
+		if (num_stack[stack_index - 1] != 0.0) {
+			if (op->store == 'X' || op->store == 'N') {
+				heap->num = num_stack[stack_index];
+			}
+			if (op->store == 'X' || op->store == 'S') {
+				xsg_string_assign(heap->str,
+						str_stack[stack_index].str);
+			}
+		}
+		stack_index -= 2;
+	}
+}
+
+static op_t **
+get_ops(xsg_rpn_t *rpn, unsigned *len)
+{
+	xsg_list_t *l;
+	op_t **ops;
+	unsigned i;
+
+	*len = xsg_list_length(rpn->op_list);
+	ops = xsg_new(op_t *, *len);
+
+	for (l = rpn->op_list, i = 0; l; l = l->next, i++) {
+		ops[i] = (op_t *) l->data;
+	}
+
+	return ops;
+}
+
+static void
+set_ops(xsg_rpn_t *rpn, op_t **ops, unsigned len)
+{
+	unsigned i;
+
+	xsg_list_free(rpn->op_list);
+	rpn->op_list = NULL;
+
+	for (i = len; i > 0; i--) {
+		rpn->op_list = xsg_list_prepend(rpn->op_list, ops[i - 1]);
+	}
+}
+
+/* every element on the stack is the result of a contiguous range of ops,
+ * only the first element pushed by an op knows where its range starts */
+
+#define NO_START ((unsigned) -1)
+
+static unsigned
+track(unsigned *starts, unsigned *depth, op_t *op, unsigned index)
+{
+	unsigned start, i;
+
+	if (op->pops == 0) {
+		start = index;
+	} else {
+		start = starts[*depth - op->pops];
+	}
+
+	*depth -= op->pops;
+
+	for (i = 0; i < op->pushes; i++) {
+		starts[*depth] = (i == 0) ? start : NO_START;
+		*depth += 1;
+	}
+
+	return start;
+}
+
+/* ops and literals only depend on the stack, static module loads never
+ * change and pure module loads only change in update functions */
+
+static bool
+is_foldable(op_t **ops, unsigned len, bool pure)
+{
+	unsigned i;
+
+	for (i = 0; i < len; i++) {
+		op_t *op = ops[i];
+
+		if (op->op != NULL) {
+			continue;
+		} else if (op->store != '\0') {
+			return FALSE;
+		} else if (op->num_load == get_number
+				|| op->str_load == get_string) {
+			continue;
+		} else if (op->num_load == load_cached_number
+				|| op->str_load == load_cached_string) {
+			cache_t *cache = (cache_t *) op->arg;
+
+			if (!pure && !cache->constant) {
+				return FALSE;
+			}
+		} else {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static void
+free_op(op_t *op)
+{
+	if (op->num_load == get_number || op->str_load == get_string) {
+		xsg_free(op->arg);
+	}
+	xsg_free(op);
+}
+
+static void
+fold(xsg_rpn_t *rpn)
+{
+	op_t **ops;
+	unsigned *starts;
+	unsigned n, len, depth, j;
+
+	ops = get_ops(rpn, &n);
+	starts = alloca(sizeof(unsigned) * max_stack_size);
+
+	len = 0;
+	depth = 0;
+
+	for (j = 0; j < n; j++) {
+		op_t *op = ops[j];
+		op_t *literal;
+		unsigned start, i;
+
+		start = track(starts, &depth, op, len);
+		ops[len++] = op;
+
+		if (op->pushes != 1 || start == NO_START) {
+			continue;
+		}
+
+		if (len - start == 1 && (op->num_load == get_number
+				|| op->str_load == get_string)) {
+			continue;
+		}
+
+		if (op->type != 'N' && op->type != 'S') {
+			continue;
+		}
+
+		if (!is_foldable(ops + start, len - start, FALSE)) {
+			continue;
+		}
+
+		stack_index = -1;
+
+		for (i = start; i < len; i++) {
+			exec(ops[i]);
+		}
+
+		literal = xsg_new0(op_t, 1);
+
+		if (op->type == 'N') {
+			double *numberp = xsg_new(double, 1);
+			*numberp = num_stack[stack_index];
+			literal->num_load = get_number;
+			literal->arg = (void *) numberp;
+		} else {
+			literal->str_load = get_string;
+			literal->arg = xsg_strdup(str_stack[stack_index].str);
+		}
+
+		literal->pushes = 1;
+		literal->type = op->type;
+
+		for (i = start; i < len; i++) {
+			free_op(ops[i]);
+		}
+
+		len = start;
+		ops[len++] = literal;
+	}
+
+	set_ops(rpn, ops, len);
+	xsg_free(ops);
+}
+
+static shared_t *
+find_shared(op_t **ops, unsigned len)
+{
+	xsg_string_t *key;
+	shared_t *shared;
+	unsigned i;
+
+	key = xsg_string_new(NULL);
+
+	for (i = 0; i < len; i++) {
+		op_t *op = ops[i];
+
+		if (op->op != NULL) {
+			xsg_string_append_printf(key, "o%p,", (void *) op->op);
+		} else if (op->num_load == get_number) {
+			xsg_string_append_printf(key, "n%a,",
+					*(double *) op->arg);
+		} else if (op->str_load == get_string) {
+			xsg_string_append_printf(key, "s%u:%s,",
+					(unsigned) strlen((char *) op->arg),
+					(char *) op->arg);
+		} else {
+			xsg_string_append_printf(key, "c%p,", op->arg);
+		}
+	}
+
+	if (shared_table == NULL) {
+		shared_table = xsg_hash_table_new(xsg_str_hash, xsg_str_equal);
+	}
+
+	shared = xsg_hash_table_lookup(shared_table, key->str);
+
+	if (shared != NULL) {
+		xsg_string_free(key, TRUE);
+		return shared;
+	}
+
+	shared = xsg_new(shared_t, 1);
+
+	shared->ops = xsg_new(op_t *, len);
+	memcpy(shared->ops, ops, sizeof(op_t *) * len);
+	shared->len = len;
+	shared->count = 0;
+	shared->insns = NULL;
+	shared->update_count = (uint64_t) -1;
+	shared->num = DNAN;
+
+	xsg_hash_table_insert(shared_table, xsg_string_free(key, FALSE), shared);
+
+	return shared;
+}
+
+/* number sub-expressions with pure loads, indexed by their last op */
+
+static void
+find_candidates(op_t **ops, unsigned n, shared_t **cand, unsigned *cand_start)
+{
+	unsigned *starts;
+	unsigned depth, i;
+
+	starts = alloca(sizeof(unsigned) * max_stack_size);
+	depth = 0;
+
+	for (i = 0; i < n; i++) {
+		unsigned start;
+
+		start = track(starts, &depth, ops[i], i);
+		cand[i] = NULL;
+
+		if (ops[i]->pushes != 1 || ops[i]->type != 'N') {
+			continue;
+		}
+
+		if (start == NO_START || start == i) {
+			continue;
+		}
+
+		if (!is_foldable(ops + start, i - start + 1, TRUE)) {
+			continue;
+		}
+
+		cand[i] = find_shared(ops + start, i - start + 1);
+		cand_start[i] = start;
+	}
+}
+
+static void
+count_shared(xsg_rpn_t *rpn)
+{
+	shared_t **cand;
+	unsigned *cand_start;
+	op_t **ops;
+	unsigned n, i;
+
+	ops = get_ops(rpn, &n);
+	cand = alloca(sizeof(shared_t *) * n);
+	cand_start = alloca(sizeof(unsigned) * n);
+
+	find_candidates(ops, n, cand, cand_start);
+
+	for (i = 0; i < n; i++) {
+		if (cand[i] != NULL) {
+			cand[i]->count++;
+		}
+	}
+
+	xsg_free(ops);
+}
+
+static void
+share(xsg_rpn_t *rpn)
+{
+	shared_t **cand;
+	unsigned *cand_start;
+	op_t **ops, **new_ops;
+	unsigned n, len, i;
+
+	ops = get_ops(rpn, &n);
+	new_ops = alloca(sizeof(op_t *) * n);
+	cand = alloca(sizeof(shared_t *) * n);
+	cand_start = alloca(sizeof(unsigned) * n);
+
+	find_candidates(ops, n, cand, cand_start);
+
+	/* walk backwards, so the outermost sub-expressions are taken */
+	len = n;
+	i = n;
+
+	while (i > 0) {
+		i--;
+
+		if (cand[i] != NULL && cand[i]->count > 1) {
+			op_t *op = xsg_new0(op_t, 1);
+
+			op->num_load = load_shared_number;
+			op->arg = (void *) cand[i];
+			op->pushes = 1;
+			op->type = 'N';
+
+			if (cand[i]->insns == NULL) {
+				cand[i]->insns = compile(cand[i]->ops,
+						cand[i]->len);
 			}
-		} else if (xsg_conf_find_command("EXC")) {
-			/* NOTE: order is important! "XX" needs to be first!
-			 * then "XN", "XS", "NX", "SX" */
-			if (pop(rpn->stack, "XX")) {
-				op->op = op_exc;
-				PUSH("XX");
-			} else if (pop(rpn->stack, "XN")) {
-				op->op = op_exc;
-				PUSH("NX");
-			} else if (pop(rpn->stack, "XS")) {
-				op->op = op_exc;
-				PUSH("SX");
-			} else if (pop(rpn->stack, "NX")) {
-				op->op = op_exc;
-				PUSH("XN");
-			} else if (pop(rpn->stack, "SX")) {
-				op->op = op_exc;
-				PUSH("XS");
-			} else if (pop(rpn->stack, "NS")) {
-				op->op = op_exc;
-				PUSH("SN");
-			} else if (pop(rpn->stack, "SN")) {
-				op->op = op_exc;
-				PUSH("NS");
-			} else if (pop(rpn->stack, "NN")) {
-				op->op = op_exc_nn;
-				PUSH("NN");
-			} else if (pop(rpn->stack, "SS")) {
-				op->op = op_exc_ss;
-				PUSH("SS");
-			} else {
-				xsg_conf_error("RPN: EXC: no two elements on "
-						"the stack");
+
+			new_ops[--len] = op;
+			i = cand_start[i];
+		} else {
+			new_ops[--len] = ops[i];
+		}
+	}
+
+	set_ops(rpn, new_ops + len, n - len);
+	xsg_free(ops);
+}
+
+/* an expression is tracked if its value only depends on pure module getters,
+ * it then needs to be evaluated again only after one of them changed */
+
+static void
+track_sources(xsg_rpn_t *rpn)
+{
+	xsg_list_t *l;
+	unsigned i;
+
+	rpn->tracked = TRUE;
+
+	for (l = rpn->op_list; l; l = l->next) {
+		op_t *op = (op_t *) l->data;
+		cache_t *cache;
+
+		if (op->op != NULL) {
+			continue;
+		} else if (op->num_load == get_number
+				|| op->str_load == get_string) {
+			continue;
+		} else if (op->num_load != load_cached_number
+				&& op->str_load != load_cached_string) {
+			rpn->tracked = FALSE;
+			break;
+		}
+
+		cache = (cache_t *) op->arg;
+
+		if (cache->constant) {
+			continue;
+		}
+
+		for (i = 0; i < rpn->source_count; i++) {
+			if (rpn->sources[i] == cache) {
+				break;
 			}
-		} else if (xsg_conf_find_command("ATOF")) {
-			POP("S", "ATOF");
-			op->op = op_atof;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ATOI")) {
-			POP("S", "ATOI");
-			op->op = op_atoi;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ATOL")) {
-			POP("S", "ATOL");
-			op->op = op_atol;
-			PUSH("N");
-		} else if (xsg_conf_find_command("ATOLL")) {
-			POP("S", "ATOLL");
-			op->op = op_atoll;
-			PUSH("N");
-		} else if (xsg_conf_find_command("STRTOF")) {
-			POP("S", "STRTOF");
-			op->op = op_strtof;
-			PUSH("X");
-		} else if (xsg_conf_find_command("STRTOD")) {
-			POP("S", "STRTOD");
-			op->op = op_strtod;
-			PUSH("X");
-		} else if (xsg_conf_find_command("STRTOLD")) {
-			POP("S", "STRTOLD");
-			op->op = op_strtold;
-			PUSH("X");
-		} else if (xsg_conf_find_command("STRTOL")) {
-			POP("SN", "STRTOL");
-			op->op = op_strtol;
-			PUSH("X");
-		} else if (xsg_conf_find_command("STRTOLL")) {
-			POP("SN", "STRTOLL");
-			op->op = op_strtoll;
-			PUSH("X");
-		} else if (xsg_conf_find_command("STRTOUL")) {
-			POP("SN", "STRTOUL");
-			op->op = op_strtoul;
-			PUSH("X");
-		} else if (xsg_conf_find_command("STRTOULL")) {
-			POP("SN", "STRTOULL");
-			op->op = op_strtoull;
+		}
+
+		if (i == rpn->source_count) {
+			rpn->sources = xsg_renew(cache_t *, rpn->sources,
+					rpn->source_count + 1);
+			rpn->sources[rpn->source_count++] = cache;
+		}
+
+		if (cache->str_load != NULL && cache->seen == NULL) {
+			cache->seen = xsg_string_new(NULL);
+		}
+	}
+
+	if (!rpn->tracked) {
+		xsg_free(rpn->sources);
+		rpn->sources = NULL;
+		rpn->source_count = 0;
+	}
+}
+
+static void
+compile_all(void)
+{
+	xsg_list_t *l;
+
+	for (l = pending_list; l; l = l->next) {
+		resolve_heaps((xsg_rpn_t *) l->data);
+	}
+
+	for (l = pending_list; l; l = l->next) {
+		fold((xsg_rpn_t *) l->data);
+	}
+
+	for (l = pending_list; l; l = l->next) {
+		track_sources((xsg_rpn_t *) l->data);
+	}
+
+	for (l = pending_list; l; l = l->next) {
+		count_shared((xsg_rpn_t *) l->data);
+	}
+
+	for (l = pending_list; l; l = l->next) {
+		share((xsg_rpn_t *) l->data);
+	}
+
+	for (l = pending_list; l; l = l->next) {
+		xsg_rpn_t *rpn = (xsg_rpn_t *) l->data;
+		op_t **ops;
+		unsigned n;
+
+		ops = get_ops(rpn, &n);
+		rpn->insns = compile(ops, n);
+		xsg_free(ops);
+	}
+
+	xsg_list_free(pending_list);
+	pending_list = NULL;
+}
+
+/******************************************************************************/
+
+#define PUSH(s) do { \
+		xsg_string_append(rpn->stack, s); \
+		pushed += strlen(s); \
+	} while (0)
+#define POP(s, log) \
+	if (!pop(rpn->stack, s)) { \
+		xsg_conf_error("RPN: %s: stack was '%s', but '%s' expected", \
+				log, rpn->stack->str, s); \
+	}
+
+/* ids index rpn_keyword_names, keep both in the same order */
+
+enum {
+	RPN_LOAD,
+	RPN_STORE,
+	RPN_GLOAD,
+	RPN_GSTORE,
+	RPN_NOT,
+	RPN_LT,
+	RPN_LE,
+	RPN_GT,
+	RPN_GE,
+	RPN_EQ,
+	RPN_NE,
+	RPN_ISNAN,
+	RPN_ISINF,
+	RPN_ISNANZERO,
+	RPN_ISINFZERO,
+	RPN_ISNANONE,
+	RPN_ISINFONE,
+	RPN_IF,
+	RPN_MIN,
+	RPN_MAX,
+	RPN_LIMIT,
+	RPN_PI,
+	RPN_NAN,
+	RPN_INF,
+	RPN_NEGINF,
+	RPN_NEG,
+	RPN_INC,
+	RPN_DEC,
+	RPN_ADD,
+	RPN_SUB,
+	RPN_MUL,
+	RPN_DIV,
+	RPN_MOD,
+	RPN_SIN,
+	RPN_COS,
+	RPN_LOG,
+	RPN_EXP,
+	RPN_SQRT,
+	RPN_POW,
+	RPN_ATAN2,
+	RPN_ATAN,
+	RPN_ROUND,
+	RPN_FLOOR,
+	RPN_CEIL,
+	RPN_DEG2RAD,
+	RPN_RAD2DEG,
+	RPN_ABS,
+	RPN_DUP,
+	RPN_POP,
+	RPN_EXC,
+	RPN_ATOF,
+	RPN_ATOI,
+	RPN_ATOL,
+	RPN_ATOLL,
+	RPN_STRTOF,
+	RPN_STRTOD,
+	RPN_STRTOLD,
+	RPN_STRTOL,
+	RPN_STRTOLL,
+	RPN_STRTOUL,
+	RPN_STRTOULL,
+	RPN_STRLEN,
+	RPN_STRCMP,
+	RPN_STRCASECMP,
+	RPN_STRUP,
+	RPN_STRDOWN,
+	RPN_STRREVERSE,
+	RPN_STRCHUG,
+	RPN_STRCHOMP,
+	RPN_STRTRUNCATE,
+	RPN_DELTA,
+	RPN_RATE,
+	RPN_EWMA,
+	RPN_WINAVG,
+	RPN_WINMIN,
+	RPN_WINMAX,
+	RPN_VADD,
+	RPN_VSUB,
+	RPN_VMUL,
+	RPN_VDIV,
+	RPN_VSUM,
+	RPN_VAVG,
+	RPN_VMIN,
+	RPN_VMAX,
+	RPN_VLEN,
+	RPN_VGET,
+	RPN_VDELTA,
+};
+
+static const char * const rpn_keyword_names[] = {
+	"LOAD",
+	"STORE",
+	"GLOAD",
+	"GSTORE",
+	"NOT",
+	"LT",
+	"LE",
+	"GT",
+	"GE",
+	"EQ",
+	"NE",
+	"ISNAN",
+	"ISINF",
+	"ISNANZERO",
+	"ISINFZERO",
+	"ISNANONE",
+	"ISINFONE",
+	"IF",
+	"MIN",
+	"MAX",
+	"LIMIT",
+	"PI",
+	"NAN",
+	"INF",
+	"NEGINF",
+	"NEG",
+	"INC",
+	"DEC",
+	"ADD",
+	"SUB",
+	"MUL",
+	"DIV",
+	"MOD",
+	"SIN",
+	"COS",
+	"LOG",
+	"EXP",
+	"SQRT",
+	"POW",
+	"ATAN2",
+	"ATAN",
+	"ROUND",
+	"FLOOR",
+	"CEIL",
+	"DEG2RAD",
+	"RAD2DEG",
+	"ABS",
+	"DUP",
+	"POP",
+	"EXC",
+	"ATOF",
+	"ATOI",
+	"ATOL",
+	"ATOLL",
+	"STRTOF",
+	"STRTOD",
+	"STRTOLD",
+	"STRTOL",
+	"STRTOLL",
+	"STRTOUL",
+	"STRTOULL",
+	"STRLEN",
+	"STRCMP",
+	"STRCASECMP",
+	"STRUP",
+	"STRDOWN",
+	"STRREVERSE",
+	"STRCHUG",
+	"STRCHOMP",
+	"STRTRUNCATE",
+	"DELTA",
+	"RATE",
+	"EWMA",
+	"WINAVG",
+	"WINMIN",
+	"WINMAX",
+	"VADD",
+	"VSUB",
+	"VMUL",
+	"VDIV",
+	"VSUM",
+	"VAVG",
+	"VMIN",
+	"VMAX",
+	"VLEN",
+	"VGET",
+	"VDELTA",
+};
+
+static xsg_conf_keywords_t rpn_keywords =
+	XSG_CONF_KEYWORDS(rpn_keyword_names);
+
+static void
+parse_load(xsg_rpn_t *rpn, op_t *op, heap_file_t *file)
+{
+	op->heap_file = file;
+	op->slot = find_heap(file, xsg_conf_read_uint());
+	op->num_load = load_number;
+	op->str_load = load_string;
+	PUSH("X");
+}
+
+static void
+parse_store(xsg_rpn_t *rpn, op_t *op, heap_file_t *file, const char *log)
+{
+	op->heap_file = file;
+	op->slot = find_heap(file, xsg_conf_read_uint());
+	/* NOTE: "NX" needs to be first!
+	 * ("NN" and "NS" will match "NX" too) */
+	if (pop(rpn->stack, "NX")) {
+		op->store = 'X';
+	} else if (pop(rpn->stack, "NN")) {
+		op->store = 'N';
+	} else if (pop(rpn->stack, "NS")) {
+		op->store = 'S';
+	} else {
+		xsg_conf_error("RPN: %s: stack was '%s', "
+				"but 'NN' or 'NS' expected",
+				log, rpn->stack->str);
+	}
+}
+
+static bool
+parse_keyword(xsg_rpn_t *rpn, op_t *op)
+{
+	switch (xsg_conf_find_keyword(&rpn_keywords)) {
+	case RPN_LOAD:
+		parse_load(rpn, op, &rpn->heap_file);
+		break;
+	case RPN_STORE:
+		parse_store(rpn, op, &rpn->heap_file, "STORE");
+		break;
+	case RPN_GLOAD:
+		parse_load(rpn, op, &global_heap_file);
+		break;
+	case RPN_GSTORE:
+		parse_store(rpn, op, &global_heap_file, "GSTORE");
+		break;
+	case RPN_NOT:
+		POP("N", "NOT");
+		op->op = op_not;
+		PUSH("N");
+		break;
+	case RPN_LT:
+		POP("NN", "LT");
+		op->op = op_lt;
+		PUSH("N");
+		break;
+	case RPN_LE:
+		POP("NN", "LE");
+		op->op = op_le;
+		PUSH("N");
+		break;
+	case RPN_GT:
+		POP("NN", "GT");
+		op->op = op_gt;
+		PUSH("N");
+		break;
+	case RPN_GE:
+		POP("NN", "GE");
+		op->op = op_ge;
+		PUSH("N");
+		break;
+	case RPN_EQ:
+		POP("NN", "EQ");
+		op->op = op_eq;
+		PUSH("N");
+		break;
+	case RPN_NE:
+		POP("NN", "NE");
+		op->op = op_ne;
+		PUSH("N");
+		break;
+	case RPN_ISNAN:
+		POP("N", "ISNAN");
+		op->op = op_isnan;
+		PUSH("N");
+		break;
+	case RPN_ISINF:
+		POP("N", "ISINF");
+		op->op = op_isinf;
+		PUSH("N");
+		break;
+	case RPN_ISNANZERO:
+		POP("N", "ISNANZERO");
+		op->op = op_isnanzero;
+		PUSH("N");
+		break;
+	case RPN_ISINFZERO:
+		POP("N", "ISINFZERO");
+		op->op = op_isinfzero;
+		PUSH("N");
+		break;
+	case RPN_ISNANONE:
+		POP("N", "ISNANONE");
+		op->op = op_isnanone;
+		PUSH("N");
+		break;
+	case RPN_ISINFONE:
+		POP("N", "ISINFONE");
+		op->op = op_isinfone;
+		PUSH("N");
+		break;
+	case RPN_IF:
+		/* NOTE: "NXX" needs to be first!
+		 * ("NNN" and "NSS" will match "NXX" too) */
+		if (pop(rpn->stack, "NXX")) {
+			op->op = op_if;
 			PUSH("X");
-		} else if (xsg_conf_find_command("STRLEN")) {
-			POP("S", "STRLEN");
-			op->op = op_strlen;
+		} else if (pop(rpn->stack, "NNN")) {
+			op->op = op_if_num;
 			PUSH("N");
-		} else if (xsg_conf_find_command("STRCMP")) {
-			POP("SS", "STRCMP");
-			op->op = op_strcmp;
-			PUSH("N");
-		} else if (xsg_conf_find_command("STRCASECMP")) {
-			POP("SS", "STRCASECMP");
-			op->op = op_strcasecmp;
-			PUSH("N");
-		} else if (xsg_conf_find_command("STRUP")) {
-			POP("S", "STRUP");
-			op->op = op_strup;
-			PUSH("S");
-		} else if (xsg_conf_find_command("STRDOWN")) {
-			POP("S", "STRDOWN");
-			op->op = op_strdown;
-			PUSH("S");
-		} else if (xsg_conf_find_command("STRREVERSE")) {
-			POP("S", "STRREVERSE");
-			op->op = op_strreverse;
-			PUSH("S");
-		} else if (xsg_conf_find_command("STRCHUG")) {
-			POP("S", "STRCHUG");
-			op->op = op_strchug;
-			PUSH("S");
-		} else if (xsg_conf_find_command("STRCHOMP")) {
-			POP("S", "STRCHOMP");
-			op->op = op_strchomp;
-			PUSH("S");
-		} else if (xsg_conf_find_command("STRTRUNCATE")) {
-			POP("SN", "STRTRUNCATE");
-			op->op = op_strtruncate;
+		} else if (pop(rpn->stack, "NSS")) {
+			op->op = op_if_str;
 			PUSH("S");
 		} else {
+			xsg_conf_error("RPN: IF: stack was '%s', but "
+					"'NNN' or 'NSS' expected",
+					rpn->stack->str);
+		}
+		break;
+	case RPN_MIN:
+		POP("NN", "MIN");
+		op->op = op_min;
+		PUSH("N");
+		break;
+	case RPN_MAX:
+		POP("NN", "MAX");
+		op->op = op_max;
+		PUSH("N");
+		break;
+	case RPN_LIMIT:
+		POP("NNN", "LIMIT");
+		op->op = op_limit;
+		PUSH("N");
+		break;
+	case RPN_PI:
+		op->op = op_pi;
+		PUSH("N");
+		break;
+	case RPN_NAN:
+		op->op = op_nan;
+		PUSH("N");
+		break;
+	case RPN_INF:
+		op->op = op_inf;
+		PUSH("N");
+		break;
+	case RPN_NEGINF:
+		op->op = op_neginf;
+		PUSH("N");
+		break;
+	case RPN_NEG:
+		POP("N", "NEG");
+		op->op = op_neg;
+		PUSH("N");
+		break;
+	case RPN_INC:
+		POP("N", "INC");
+		op->op = op_inc;
+		PUSH("N");
+		break;
+	case RPN_DEC:
+		POP("N", "DEC");
+		op->op = op_dec;
+		PUSH("N");
+		break;
+	case RPN_ADD:
+		POP("NN", "ADD");
+		op->op = op_add;
+		PUSH("N");
+		break;
+	case RPN_SUB:
+		POP("NN", "SUB");
+		op->op = op_sub;
+		PUSH("N");
+		break;
+	case RPN_MUL:
+		POP("NN", "MUL");
+		op->op = op_mul;
+		PUSH("N");
+		break;
+	case RPN_DIV:
+		POP("NN", "DIV");
+		op->op = op_div;
+		PUSH("N");
+		break;
+	case RPN_MOD:
+		POP("NN", "MOD");
+		op->op = op_mod;
+		PUSH("N");
+		break;
+	case RPN_SIN:
+		POP("N", "SIN");
+		op->op = op_sin;
+		PUSH("N");
+		break;
+	case RPN_COS:
+		POP("N", "COS");
+		op->op = op_cos;
+		PUSH("N");
+		break;
+	case RPN_LOG:
+		POP("N", "LOG");
+		op->op = op_log;
+		PUSH("N");
+		break;
+	case RPN_EXP:
+		POP("N", "EXP");
+		op->op = op_exp;
+		PUSH("N");
+		break;
+	case RPN_SQRT:
+		POP("N", "SQRT");
+		op->op = op_sqrt;
+		PUSH("N");
+		break;
+	case RPN_POW:
+		POP("NN", "POW");
+		op->op = op_pow;
+		PUSH("N");
+		break;
+	case RPN_ATAN2:
+		POP("NN", "ATAN2");
+		op->op = op_atan2;
+		PUSH("N");
+		break;
+	case RPN_ATAN:
+		POP("N", "ATAN");
+		op->op = op_atan;
+		PUSH("N");
+		break;
+	case RPN_ROUND:
+		POP("N", "ROUND");
+		op->op = op_round;
+		PUSH("N");
+		break;
+	case RPN_FLOOR:
+		POP("N", "FLOOR");
+		op->op = op_floor;
+		PUSH("N");
+		break;
+	case RPN_CEIL:
+		POP("N", "CEIL");
+		op->op = op_ceil;
+		PUSH("N");
+		break;
+	case RPN_DEG2RAD:
+		POP("N", "DEG2RAD");
+		op->op = op_deg2rad;
+		PUSH("N");
+		break;
+	case RPN_RAD2DEG:
+		POP("N", "RAD2DEG");
+		op->op = op_rad2deg;
+		PUSH("N");
+		break;
+	case RPN_ABS:
+		POP("N", "ABS");
+		op->op = op_abs;
+		PUSH("N");
+		break;
+	case RPN_DUP:
+		/* NOTE: "X" needs to be first!
+		 * ("N" and "S" will match "X" too) */
+		if (pop(rpn->stack, "X")) {
+			op->op = op_dup;
+			PUSH("XX");
+		} else if (pop(rpn->stack, "N")) {
+			op->op = op_dup_num;
+			PUSH("NN");
+		} else if (pop(rpn->stack, "S")) {
+			op->op = op_dup_str;
+			PUSH("SS");
+		} else if (pop(rpn->stack, "V")) {
+			op->op = op_dup_vec;
+			PUSH("VV");
+		} else {
+			xsg_conf_error("RPN: DUP: no element on the "
+					"stack");
+		}
+		break;
+	case RPN_POP:
+		if (pop(rpn->stack, "X")) {
+			op->op = op_pop;
+		} else if (pop(rpn->stack, "N")) {
+			op->op = op_pop;
+		} else if (pop(rpn->stack, "S")) {
+			op->op = op_pop;
+		} else if (pop(rpn->stack, "V")) {
+			op->op = op_pop;
+		} else {
+			xsg_conf_error("RPN: POP: no element on the "
+					"stack");
+		}
+		break;
+	case RPN_EXC:
+		/* NOTE: order is important! "XX" needs to be first!
+		 * then "XN", "XS", "NX", "SX" */
+		if (pop(rpn->stack, "XX")) {
+			op->op = op_exc;
+			PUSH("XX");
+		} else if (pop(rpn->stack, "XN")) {
+			op->op = op_exc;
+			PUSH("NX");
+		} else if (pop(rpn->stack, "XS")) {
+			op->op = op_exc;
+			PUSH("SX");
+		} else if (pop(rpn->stack, "NX")) {
+			op->op = op_exc;
+			PUSH("XN");
+		} else if (pop(rpn->stack, "SX")) {
+			op->op = op_exc;
+			PUSH("XS");
+		} else if (pop(rpn->stack, "NS")) {
+			op->op = op_exc;
+			PUSH("SN");
+		} else if (pop(rpn->stack, "SN")) {
+			op->op = op_exc;
+			PUSH("NS");
+		} else if (pop(rpn->stack, "NN")) {
+			op->op = op_exc_nn;
+			PUSH("NN");
+		} else if (pop(rpn->stack, "SS")) {
+			op->op = op_exc_ss;
+			PUSH("SS");
+		} else if (pop(rpn->stack, "VX")) {
+			op->op = op_exc_vec;
+			PUSH("XV");
+		} else if (pop(rpn->stack, "XV")) {
+			op->op = op_exc_vec;
+			PUSH("VX");
+		} else if (pop(rpn->stack, "VN")) {
+			op->op = op_exc_vec;
+			PUSH("NV");
+		} else if (pop(rpn->stack, "NV")) {
+			op->op = op_exc_vec;
+			PUSH("VN");
+		} else if (pop(rpn->stack, "VS")) {
+			op->op = op_exc_vec;
+			PUSH("SV");
+		} else if (pop(rpn->stack, "SV")) {
+			op->op = op_exc_vec;
+			PUSH("VS");
+		} else if (pop(rpn->stack, "VV")) {
+			op->op = op_exc_vec;
+			PUSH("VV");
+		} else {
+			xsg_conf_error("RPN: EXC: no two elements on "
+					"the stack");
+		}
+		break;
+	case RPN_ATOF:
+		POP("S", "ATOF");
+		op->op = op_atof;
+		PUSH("N");
+		break;
+	case RPN_ATOI:
+		POP("S", "ATOI");
+		op->op = op_atoi;
+		PUSH("N");
+		break;
+	case RPN_ATOL:
+		POP("S", "ATOL");
+		op->op = op_atol;
+		PUSH("N");
+		break;
+	case RPN_ATOLL:
+		POP("S", "ATOLL");
+		op->op = op_atoll;
+		PUSH("N");
+		break;
+	case RPN_STRTOF:
+		POP("S", "STRTOF");
+		op->op = op_strtof;
+		PUSH("X");
+		break;
+	case RPN_STRTOD:
+		POP("S", "STRTOD");
+		op->op = op_strtod;
+		PUSH("X");
+		break;
+	case RPN_STRTOLD:
+		POP("S", "STRTOLD");
+		op->op = op_strtold;
+		PUSH("X");
+		break;
+	case RPN_STRTOL:
+		POP("SN", "STRTOL");
+		op->op = op_strtol;
+		PUSH("X");
+		break;
+	case RPN_STRTOLL:
+		POP("SN", "STRTOLL");
+		op->op = op_strtoll;
+		PUSH("X");
+		break;
+	case RPN_STRTOUL:
+		POP("SN", "STRTOUL");
+		op->op = op_strtoul;
+		PUSH("X");
+		break;
+	case RPN_STRTOULL:
+		POP("SN", "STRTOULL");
+		op->op = op_strtoull;
+		PUSH("X");
+		break;
+	case RPN_STRLEN:
+		POP("S", "STRLEN");
+		op->op = op_strlen;
+		PUSH("N");
+		break;
+	case RPN_STRCMP:
+		POP("SS", "STRCMP");
+		op->op = op_strcmp;
+		PUSH("N");
+		break;
+	case RPN_STRCASECMP:
+		POP("SS", "STRCASECMP");
+		op->op = op_strcasecmp;
+		PUSH("N");
+		break;
+	case RPN_STRUP:
+		POP("S", "STRUP");
+		op->op = op_strup;
+		PUSH("S");
+		break;
+	case RPN_STRDOWN:
+		POP("S", "STRDOWN");
+		op->op = op_strdown;
+		PUSH("S");
+		break;
+	case RPN_STRREVERSE:
+		POP("S", "STRREVERSE");
+		op->op = op_strreverse;
+		PUSH("S");
+		break;
+	case RPN_STRCHUG:
+		POP("S", "STRCHUG");
+		op->op = op_strchug;
+		PUSH("S");
+		break;
+	case RPN_STRCHOMP:
+		POP("S", "STRCHOMP");
+		op->op = op_strchomp;
+		PUSH("S");
+		break;
+	case RPN_STRTRUNCATE:
+		POP("SN", "STRTRUNCATE");
+		op->op = op_strtruncate;
+		PUSH("S");
+		break;
+	case RPN_DELTA:
+		POP("N", "DELTA");
+		op->op_state = op_delta;
+		op->arg = (void *) new_delta();
+		PUSH("N");
+		break;
+	case RPN_RATE:
+		POP("N", "RATE");
+		op->op_state = op_rate;
+		op->arg = (void *) new_delta();
+		PUSH("N");
+		break;
+	case RPN_EWMA: {
+		ewma_t *ewma = xsg_new(ewma_t, 1);
+		ewma->alpha = xsg_conf_read_double();
+		ewma->avg = DNAN;
+		if (!(ewma->alpha > 0.0 && ewma->alpha <= 1.0)) {
+			xsg_conf_error("RPN: EWMA: 0 < alpha <= 1 "
+					"expected");
+		}
+		POP("N", "EWMA");
+		op->op_state = op_ewma;
+		op->arg = (void *) ewma;
+		PUSH("N");
+		break;
+	}
+	case RPN_WINAVG: {
+		unsigned size = xsg_conf_read_uint();
+		if (size < 1) {
+			xsg_conf_error("RPN: WINAVG: size > 0 expected");
+		}
+		POP("N", "WINAVG");
+		op->op_state = op_winavg;
+		op->arg = (void *) new_window(size, FALSE);
+		PUSH("N");
+		break;
+	}
+	case RPN_WINMIN: {
+		unsigned size = xsg_conf_read_uint();
+		if (size < 1) {
+			xsg_conf_error("RPN: WINMIN: size > 0 expected");
+		}
+		POP("N", "WINMIN");
+		op->op_state = op_winminmax;
+		op->arg = (void *) new_window(size, FALSE);
+		PUSH("N");
+		break;
+	}
+	case RPN_WINMAX: {
+		unsigned size = xsg_conf_read_uint();
+		if (size < 1) {
+			xsg_conf_error("RPN: WINMAX: size > 0 expected");
+		}
+		POP("N", "WINMAX");
+		op->op_state = op_winminmax;
+		op->arg = (void *) new_window(size, TRUE);
+		PUSH("N");
+		break;
+	}
+	case RPN_VADD:
+		if (pop(rpn->stack, "VV")) {
+			op->op = op_vadd_vv;
+		} else if (pop(rpn->stack, "VN")) {
+			op->op = op_vadd_vn;
+		} else {
+			xsg_conf_error("RPN: VADD: stack was '%s', "
+					"but 'VV' or 'VN' expected",
+					rpn->stack->str);
+		}
+		PUSH("V");
+		break;
+	case RPN_VSUB:
+		if (pop(rpn->stack, "VV")) {
+			op->op = op_vsub_vv;
+		} else if (pop(rpn->stack, "VN")) {
+			op->op = op_vsub_vn;
+		} else {
+			xsg_conf_error("RPN: VSUB: stack was '%s', "
+					"but 'VV' or 'VN' expected",
+					rpn->stack->str);
+		}
+		PUSH("V");
+		break;
+	case RPN_VMUL:
+		if (pop(rpn->stack, "VV")) {
+			op->op = op_vmul_vv;
+		} else if (pop(rpn->stack, "VN")) {
+			op->op = op_vmul_vn;
+		} else {
+			xsg_conf_error("RPN: VMUL: stack was '%s', "
+					"but 'VV' or 'VN' expected",
+					rpn->stack->str);
+		}
+		PUSH("V");
+		break;
+	case RPN_VDIV:
+		if (pop(rpn->stack, "VV")) {
+			op->op = op_vdiv_vv;
+		} else if (pop(rpn->stack, "VN")) {
+			op->op = op_vdiv_vn;
+		} else {
+			xsg_conf_error("RPN: VDIV: stack was '%s', "
+					"but 'VV' or 'VN' expected",
+					rpn->stack->str);
+		}
+		PUSH("V");
+		break;
+	case RPN_VSUM:
+		POP("V", "VSUM");
+		op->op = op_vsum;
+		PUSH("N");
+		break;
+	case RPN_VAVG:
+		POP("V", "VAVG");
+		op->op = op_vavg;
+		PUSH("N");
+		break;
+	case RPN_VMIN:
+		POP("V", "VMIN");
+		op->op = op_vmin;
+		PUSH("N");
+		break;
+	case RPN_VMAX:
+		POP("V", "VMAX");
+		op->op = op_vmax;
+		PUSH("N");
+		break;
+	case RPN_VLEN:
+		POP("V", "VLEN");
+		op->op = op_vlen;
+		PUSH("N");
+		break;
+	case RPN_VGET: {
+		unsigned *index = xsg_new(unsigned, 1);
+		*index = xsg_conf_read_uint();
+		POP("V", "VGET");
+		op->op_state = op_vget;
+		op->arg = (void *) index;
+		PUSH("N");
+		break;
+	}
+	case RPN_VDELTA:
+		POP("V", "VDELTA");
+		op->op_state = op_vdelta;
+		op->arg = (void *) xsg_new0(vec_t, 1);
+		PUSH("V");
+		break;
+	default:
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static xsg_rpn_t *
+parse(uint64_t update, xsg_var_t *var)
+{
+	xsg_rpn_t *rpn;
+	xsg_list_t *op_last = NULL;
+
+	rpn = xsg_new(xsg_rpn_t, 1);
+
+	rpn->op_list = NULL;
+	rpn->insns = NULL;
+	rpn->stack = xsg_string_new(NULL);
+	rpn->heap_file.ids = NULL;
+	rpn->heap_file.heaps = NULL;
+	rpn->heap_file.len = 0;
+	rpn->sources = NULL;
+	rpn->source_count = 0;
+	rpn->tracked = FALSE;
+	rpn->version = UINT64_MAX;
+	rpn->profile = NULL;
+
+	/* init functions of modules parsed later on run first */
+	xsg_main_add_init_func(compile_all);
+
+	if (xsg_profile_enabled) {
+		char *location = xsg_conf_get_location();
+
+		rpn->profile = xsg_profile_new("rpn", location);
+		xsg_free(location);
+	}
+
+	do {
+		double number;
+		char *string;
+		op_t *op;
+
+		op = xsg_new0(op_t, 1);
+
+		popped = 0;
+		pushed = 0;
+
+		if (xsg_conf_find_number(&number)) {
+			double *numberp = xsg_new(double, 1);
+			*numberp = number;
+			op->num_load = get_number;
+			op->arg = (void *) numberp;
+			PUSH("N");
+		} else if (xsg_conf_find_string(&string)) {
+			op->str_load = get_string;
+			op->arg = (void *) string;
+			PUSH("S");
+		} else if (!parse_keyword(rpn, op)) {
 			double (*num)(void *);
 			const char *(*str)(void *);
 			void *arg;
+			cache_t *cache;
+			vector_t *vector;
 
 			if (!xsg_modules_parse(update, var, &num, &str, &arg)) {
 				xsg_conf_error("number, string, module name, "
-						"LOAD, STORE, NOT"
+						"LOAD, STORE, GLOAD, GSTORE, NOT, "
 						"LT, LE, GT, GE, EQ, NE, "
 						"ISNAN, ISINF, ISNANZERO, "
 						"ISINFZERO, ISNANONE, ISINFONE, "
@@ -1254,15 +3249,38 @@ parse(uint64_t update, xsg_var_t *var)
 						"STRTOL, STRTOLL, STRTOUL, "
 						"STRTOULL, STRLEN, STRCMP, "
 						"STRCASECMP, STRUP, STRDOWN "
-						"STRREVERSE, STRCHUG, STRCHOMP "
-						"or STRTRUNCATE expected");
+						"STRREVERSE, STRCHUG, STRCHOMP, "
+						"STRTRUNCATE, DELTA, RATE, "
+						"EWMA, WINAVG, WINMIN, WINMAX, "
+						"VADD, VSUB, VMUL, VDIV, "
+						"VSUM, VAVG, VMIN, VMAX, "
+						"VLEN, VGET or VDELTA expected");
 			}
 
 			op->num_load = num;
 			op->str_load = str;
 			op->arg = arg;
 
-			if (num != NULL && str != NULL) {
+			vector = find_vector(num, arg);
+			cache = find_cache(num, str, arg);
+
+			if (vector != NULL) {
+				op->num_load = NULL;
+				op->str_load = NULL;
+				op->vec_load = vector->vec_load;
+			} else if (cache != NULL) {
+				if (num != NULL) {
+					op->num_load = load_cached_number;
+				}
+				if (str != NULL) {
+					op->str_load = load_cached_string;
+				}
+				op->arg = (void *) cache;
+			}
+
+			if (vector != NULL) {
+				PUSH("V");
+			} else if (num != NULL && str != NULL) {
 				PUSH("X");
 			} else if (num != NULL) {
 				PUSH("N");
@@ -1276,17 +3294,30 @@ parse(uint64_t update, xsg_var_t *var)
 
 			num_stack = xsg_renew(double, num_stack,
 					rpn->stack->len);
-			str_stack = xsg_renew(xsg_string_t *, str_stack,
+			str_stack = xsg_renew(str_t, str_stack,
+					rpn->stack->len);
+			vec_stack = xsg_renew(vec_t, vec_stack,
 					rpn->stack->len);
 
 			for (j = max_stack_size; j < rpn->stack->len; j++) {
-				str_stack[j] = xsg_string_new(NULL);
+				str_stack[j].buf = xsg_string_new(NULL);
+				str_stack[j].str = str_stack[j].buf->str;
+				vec_stack[j].num = NULL;
+				vec_stack[j].len = 0;
+				vec_stack[j].size = 0;
 			}
 
 			max_stack_size = rpn->stack->len;
 		}
 
-		rpn->op_list = xsg_list_append(rpn->op_list, op);
+		op->pops = popped;
+		op->pushes = pushed;
+
+		if (pushed == 1) {
+			op->type = rpn->stack->str[rpn->stack->len - 1];
+		}
+
+		rpn->op_list = xsg_list_append_last(rpn->op_list, &op_last, op);
 
 	} while (xsg_conf_find_comma());
 
@@ -1298,6 +3329,8 @@ parse(uint64_t update, xsg_var_t *var)
 		xsg_conf_error("RPN: more than one element left on the stack");
 	}
 
+	pending_list = xsg_list_prepend(pending_list, rpn);
+
 	return rpn;
 }
 
@@ -1335,50 +3368,240 @@ xsg_rpn_parse_str(uint64_t update, xsg_var_t *var)
 	return rpn;
 }
 
+xsg_rpn_t *
+xsg_rpn_parse_vec(uint64_t update, xsg_var_t *var)
+{
+	xsg_rpn_t *rpn;
+	char type;
+
+	rpn = parse(update, var);
+
+	type = rpn->stack->str[rpn->stack->len - 1];
+
+	if (unlikely(type != 'V')) {
+		xsg_conf_error("RPN: no vector left on the stack");
+	}
+
+	return rpn;
+}
+
 /******************************************************************************/
 
 static void
-calc(xsg_rpn_t *rpn)
+limit(double *value, double min, double max)
 {
-	xsg_list_t *l;
+	if (isnan(*value)) {
+		;
+	} else if (isnan(min)) {
+		*value = min;
+	} else if (isnan(max)) {
+		*value = max;
+	} else if (*value < min) {
+		*value = DNAN;
+	} else if (*value > max) {
+		*value = DNAN;
+	}
+}
 
-	stack_index = -1;
+/* threaded dispatch through computed goto, a switch otherwise */
 
-	for (l = rpn->op_list; l; l = l->next) {
-		op_t *op = (op_t *) l->data;
+#if defined(__GNUC__)
+# define INSN(code) L_##code
+# define DISPATCH() goto *labels[insn->code]
+#else
+# define INSN(code) case code
+# define DISPATCH() goto dispatch
+#endif
 
-		if (op->op) {
-			op->op();
-		} else if (op->num_load || op->str_load) {
-			stack_index++;
-			if (op->num_load) {
-				num_stack[stack_index] = op->num_load(op->arg);
-			}
-			if (op->str_load) {
-				const char *s = op->str_load(op->arg);
+#define NEXT() do { insn++; DISPATCH(); } while (0)
+
+static unsigned
+run(const insn_t *insn, unsigned sp)
+{
+#if defined(__GNUC__)
+	static const void *labels[INSN_COUNT] = {
+		[INSN_END] = &&L_INSN_END,
+		[INSN_OP] = &&L_INSN_OP,
+		[INSN_OP_STATE] = &&L_INSN_OP_STATE,
+		[INSN_LOAD_NUM] = &&L_INSN_LOAD_NUM,
+		[INSN_LOAD_STR] = &&L_INSN_LOAD_STR,
+		[INSN_LOAD_BOTH] = &&L_INSN_LOAD_BOTH,
+		[INSN_LOAD_HEAP] = &&L_INSN_LOAD_HEAP,
+		[INSN_LOAD_VEC] = &&L_INSN_LOAD_VEC,
+		[INSN_CONST] = &&L_INSN_CONST,
+		[INSN_STORE] = &&L_INSN_STORE,
+		[INSN_ADD] = &&L_INSN_ADD,
+		[INSN_SUB] = &&L_INSN_SUB,
+		[INSN_MUL] = &&L_INSN_MUL,
+		[INSN_DIV] = &&L_INSN_DIV,
+		[INSN_LIMIT] = &&L_INSN_LIMIT,
+		[INSN_LOAD_ADD] = &&L_INSN_LOAD_ADD,
+		[INSN_LOAD_SUB] = &&L_INSN_LOAD_SUB,
+		[INSN_LOAD_MUL] = &&L_INSN_LOAD_MUL,
+		[INSN_LOAD_DIV] = &&L_INSN_LOAD_DIV,
+		[INSN_CONST_ADD] = &&L_INSN_CONST_ADD,
+		[INSN_CONST_SUB] = &&L_INSN_CONST_SUB,
+		[INSN_CONST_MUL] = &&L_INSN_CONST_MUL,
+		[INSN_CONST_DIV] = &&L_INSN_CONST_DIV,
+		[INSN_LOAD_LOAD_DIV] = &&L_INSN_LOAD_LOAD_DIV,
+		[INSN_LOAD_LOAD_DIV_MUL] = &&L_INSN_LOAD_LOAD_DIV_MUL,
+		[INSN_CONST_LIMIT] = &&L_INSN_CONST_LIMIT,
+		[INSN_SHARED] = &&L_INSN_SHARED,
+	};
+#endif
+	double *num = num_stack;
 
-				if (s == NULL) {
-					xsg_string_truncate(str_stack[stack_index], 0);
-				} else {
-					xsg_string_assign(str_stack[stack_index], s);
-				}
-			}
-		} else if (op->store != '\0') {
-			heap_t *heap = (heap_t *) op->arg;
+	DISPATCH();
 
-			if (op->store == 'X' || op->store == 'N') {
-				if (num_stack[stack_index - 1] != 0.0) {
-					heap->num = num_stack[stack_index];
-				}
+#if !defined(__GNUC__)
+dispatch:
+	switch (insn->code) {
+#endif
+	INSN(INSN_OP):
+		stack_index = sp;
+		insn->op();
+		sp = stack_index;
+		NEXT();
+	INSN(INSN_OP_STATE):
+		stack_index = sp;
+		insn->op_state(insn->arg);
+		sp = stack_index;
+		NEXT();
+	INSN(INSN_LOAD_NUM):
+		num[++sp] = insn->num_load(insn->arg);
+		NEXT();
+	INSN(INSN_LOAD_BOTH):
+		num[sp + 1] = insn->num_load(insn->arg);
+		/* fall through */
+	INSN(INSN_LOAD_STR):
+		sp++;
+		borrow_string(sp, insn->str_load(insn->arg));
+		NEXT();
+	INSN(INSN_LOAD_HEAP): {
+		heap_t *heap = (heap_t *) insn->arg;
+
+		/* a later STORE may change the heap string */
+		sp++;
+		num[sp] = heap->num;
+		copy_string(sp, heap->str->str);
+		NEXT();
+	}
+	INSN(INSN_LOAD_VEC): {
+		const double *values;
+		unsigned len = 0;
+
+		values = insn->vec_load(insn->arg, &len);
+		load_vector(++sp, values, len);
+		NEXT();
+	}
+	INSN(INSN_CONST):
+		num[++sp] = insn->num;
+		NEXT();
+	INSN(INSN_STORE): {
+		heap_t *heap = (heap_t *) insn->arg;
+
+		if (num[sp - 1] != 0.0) {
+			if (insn->store == 'X' || insn->store == 'N') {
+				heap->num = num[sp];
 			}
-			if (op->store == 'X' || op->store == 'S') {
-				if (num_stack[stack_index - 1] != 0.0) {
-					xsg_string_assign(heap->str, str_stack[stack_index]->str);
-				}
+			if (insn->store == 'X' || insn->store == 'S') {
+				xsg_string_assign(heap->str, str_stack[sp].str);
 			}
-			stack_index -= 2;
 		}
+		sp -= 2;
+		NEXT();
+	}
+	INSN(INSN_ADD):
+		num[sp - 1] += num[sp];
+		sp--;
+		NEXT();
+	INSN(INSN_SUB):
+		num[sp - 1] -= num[sp];
+		sp--;
+		NEXT();
+	INSN(INSN_MUL):
+		num[sp - 1] *= num[sp];
+		sp--;
+		NEXT();
+	INSN(INSN_DIV):
+		num[sp - 1] /= num[sp];
+		sp--;
+		NEXT();
+	INSN(INSN_LIMIT):
+		limit(&num[sp - 2], num[sp - 1], num[sp]);
+		sp -= 2;
+		NEXT();
+	INSN(INSN_LOAD_ADD):
+		num[sp] += insn->num_load(insn->arg);
+		NEXT();
+	INSN(INSN_LOAD_SUB):
+		num[sp] -= insn->num_load(insn->arg);
+		NEXT();
+	INSN(INSN_LOAD_MUL):
+		num[sp] *= insn->num_load(insn->arg);
+		NEXT();
+	INSN(INSN_LOAD_DIV):
+		num[sp] /= insn->num_load(insn->arg);
+		NEXT();
+	INSN(INSN_CONST_ADD):
+		num[sp] += insn->num;
+		NEXT();
+	INSN(INSN_CONST_SUB):
+		num[sp] -= insn->num;
+		NEXT();
+	INSN(INSN_CONST_MUL):
+		num[sp] *= insn->num;
+		NEXT();
+	INSN(INSN_CONST_DIV):
+		num[sp] /= insn->num;
+		NEXT();
+	INSN(INSN_LOAD_LOAD_DIV): {
+		double a = insn->num_load(insn->arg);
+
+		num[++sp] = a / insn->num_load2(insn->arg2);
+		NEXT();
+	}
+	INSN(INSN_LOAD_LOAD_DIV_MUL): {
+		double a = insn->num_load(insn->arg);
+
+		num[++sp] = a / insn->num_load2(insn->arg2) * insn->num;
+		NEXT();
+	}
+	INSN(INSN_CONST_LIMIT):
+		limit(&num[sp], insn->num, insn->num2);
+		NEXT();
+	INSN(INSN_SHARED): {
+		shared_t *shared = (shared_t *) insn->arg;
+		uint64_t count = xsg_main_get_update_count();
+
+		if (shared->update_count != count) {
+			run(shared->insns, sp);
+			shared->num = num[sp + 1];
+			shared->update_count = count;
+		}
+		num[++sp] = shared->num;
+		NEXT();
+	}
+	INSN(INSN_END):
+		return sp;
+#if !defined(__GNUC__)
+	}
+	return sp;
+#endif
+}
+
+#undef INSN
+#undef DISPATCH
+#undef NEXT
+
+static void
+calc(xsg_rpn_t *rpn)
+{
+	if (unlikely(rpn->insns == NULL)) {
+		compile_all();
 	}
+
+	stack_index = run(rpn->insns, -1);
 }
 
 double
@@ -1395,17 +3618,24 @@ xsg_rpn_get_num(xsg_rpn_t *rpn)
 		return DNAN;
 	}
 #endif
-	calc(rpn);
+	if (unlikely(rpn->profile != NULL)) {
+		uint64_t start = xsg_profile_start();
+
+		calc(rpn);
+		xsg_profile_stop(rpn->profile, start);
+	} else {
+		calc(rpn);
+	}
 
 	num = num_stack[stack_index];
 
 	return num;
 }
 
-char *
+const char *
 xsg_rpn_get_str(xsg_rpn_t *rpn)
 {
-	char *str;
+	const char *str;
 #if 0
 	char type;
 
@@ -1416,10 +3646,101 @@ xsg_rpn_get_str(xsg_rpn_t *rpn)
 		return NULL;
 	}
 #endif
-	calc(rpn);
+	if (unlikely(rpn->profile != NULL)) {
+		uint64_t start = xsg_profile_start();
+
+		calc(rpn);
+		xsg_profile_stop(rpn->profile, start);
+	} else {
+		calc(rpn);
+	}
 
-	str = str_stack[stack_index]->str;
+	str = str_stack[stack_index].str;
 
 	return str;
 }
 
+const double *
+xsg_rpn_get_vec(xsg_rpn_t *rpn, unsigned *len)
+{
+	vec_t *vec;
+
+	if (unlikely(rpn->profile != NULL)) {
+		uint64_t start = xsg_profile_start();
+
+		calc(rpn);
+		xsg_profile_stop(rpn->profile, start);
+	} else {
+		calc(rpn);
+	}
+
+	vec = &vec_stack[stack_index];
+
+	*len = vec->len;
+
+	return vec->num;
+}
+
+/* time-series ops forget their previous samples */
+void
+xsg_rpn_reset(xsg_rpn_t *rpn)
+{
+	xsg_list_t *l;
+
+	for (l = rpn->op_list; l; l = l->next) {
+		op_t *op = (op_t *) l->data;
+
+		if (op->op_state == op_delta || op->op_state == op_rate) {
+			delta_t *delta = (delta_t *) op->arg;
+
+			delta->prev = DNAN;
+			delta->time = 0;
+		} else if (op->op_state == op_ewma) {
+			((ewma_t *) op->arg)->avg = DNAN;
+		} else if (op->op_state == op_winavg
+				|| op->op_state == op_winminmax) {
+			window_t *window = (window_t *) op->arg;
+
+			window->count = 0;
+			window->pos = 0;
+			window->sum = 0.0;
+			window->valid = 0;
+			window->index = 0;
+			window->head = 0;
+			window->len = 0;
+		} else if (op->op_state == op_vdelta) {
+			((vec_t *) op->arg)->len = 0;
+		}
+	}
+}
+
+bool
+xsg_rpn_changed(xsg_rpn_t *rpn)
+{
+	uint64_t version = 0;
+	unsigned i;
+
+	if (!rpn->tracked) {
+		return TRUE;
+	}
+
+	for (i = 0; i < rpn->source_count; i++) {
+		cache_t *cache = rpn->sources[i];
+
+		if (cache->num_load != NULL) {
+			load_cached_number((void *) cache);
+		}
+		if (cache->str_load != NULL) {
+			load_cached_string((void *) cache);
+		}
+		version += cache->version;
+	}
+
+	if (version == rpn->version) {
+		return FALSE;
+	}
+
+	rpn->version = version;
+
+	return TRUE;
+}
@@ -33,12 +33,24 @@ xsg_rpn_parse_num(uint64_t update, xsg_var_t *var);
 extern xsg_rpn_t *
 xsg_rpn_parse_str(uint64_t update, xsg_var_t *var);
 
+extern xsg_rpn_t *
+xsg_rpn_parse_vec(uint64_t update, xsg_var_t *var);
+
 extern double
 xsg_rpn_get_num(xsg_rpn_t *rpn);
 
-extern char *
+extern const char *
 xsg_rpn_get_str(xsg_rpn_t *rpn);
 
+extern const double *
+xsg_rpn_get_vec(xsg_rpn_t *rpn, unsigned *len);
+
+extern bool
+xsg_rpn_changed(xsg_rpn_t *rpn);
+
+extern void
+xsg_rpn_reset(xsg_rpn_t *rpn);
+
 /*****************************************************************************/
 
 #endif /* __RPN_H__ */
@@ -0,0 +1,308 @@
+/* shm.c
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * MIT-SHM upload path: every window gets one shared memory XImage of its own
+ * size. The pixels of an update are copied to their own position in the
+ * segment and sent with XShmPutImage, so they do not have to be pushed
+ * through the X socket. Rects of one frame that overlap hold the same
+ * pixels, so they are all sent without waiting. xsg_shm_begin waits for the
+ * completion of the previous frame before the segment is written again.
+ */
+
+#include <xsysguard.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <string.h>
+#include <errno.h>
+
+#include "shm.h"
+
+/******************************************************************************/
+
+struct _xsg_shm_t {
+	XShmSegmentInfo info;
+	XImage *ximage;
+	GC gc;
+	unsigned pending;
+};
+
+/******************************************************************************/
+
+static Display *display = NULL;
+
+static bool disabled = FALSE;
+static bool available = FALSE;
+static int completion_type = 0;
+
+static bool attach_error = FALSE;
+
+static xsg_list_t *shm_list = NULL;
+
+/******************************************************************************/
+
+void
+xsg_shm_disable(void)
+{
+	disabled = TRUE;
+}
+
+void
+xsg_shm_init(Display *dpy)
+{
+	int major, minor;
+	Bool pixmaps;
+
+	display = dpy;
+
+	if (disabled) {
+		xsg_message("MIT-SHM disabled");
+		return;
+	}
+
+	if (!XShmQueryExtension(display)) {
+		xsg_message("No MIT-SHM extension found");
+		return;
+	}
+
+	XShmQueryVersion(display, &major, &minor, &pixmaps);
+	xsg_message("XShmQueryVersion: %d.%d", major, minor);
+
+	completion_type = XShmGetEventBase(display) + ShmCompletion;
+	available = TRUE;
+}
+
+/******************************************************************************/
+
+static int
+attach_error_handler(Display *dpy, XErrorEvent *event)
+{
+	attach_error = TRUE;
+	return 0;
+}
+
+static void
+destroy_ximage(XImage *ximage)
+{
+	/* the data is owned by the shared memory segment */
+	ximage->data = NULL;
+	XDestroyImage(ximage);
+}
+
+xsg_shm_t *
+xsg_shm_new(Visual *visual, unsigned depth, unsigned width, unsigned height)
+{
+	XErrorHandler handler;
+	xsg_shm_t *shm;
+	void *addr;
+
+	if (!available) {
+		return NULL;
+	}
+
+	/* imlib's ARGB32 pixels are copied as they are */
+	if (visual->class != TrueColor || visual->red_mask != 0xff0000
+			|| visual->green_mask != 0x00ff00
+			|| visual->blue_mask != 0x0000ff) {
+		return NULL;
+	}
+
+	shm = xsg_new0(xsg_shm_t, 1);
+
+	shm->ximage = XShmCreateImage(display, visual, depth, ZPixmap, NULL,
+			&shm->info, width, height);
+
+	if (shm->ximage == NULL) {
+		xsg_free(shm);
+		return NULL;
+	}
+
+	if (shm->ximage->bits_per_pixel != 32) {
+		destroy_ximage(shm->ximage);
+		xsg_free(shm);
+		return NULL;
+	}
+
+	shm->info.shmid = shmget(IPC_PRIVATE, shm->ximage->bytes_per_line
+			* shm->ximage->height, IPC_CREAT | 0600);
+
+	if (shm->info.shmid < 0) {
+		xsg_warning("shmget failed: %s", strerror(errno));
+		destroy_ximage(shm->ximage);
+		xsg_free(shm);
+		return NULL;
+	}
+
+	addr = shmat(shm->info.shmid, NULL, 0);
+
+	if (addr == (void *) -1) {
+		xsg_warning("shmat failed: %s", strerror(errno));
+		shmctl(shm->info.shmid, IPC_RMID, NULL);
+		destroy_ximage(shm->ximage);
+		xsg_free(shm);
+		return NULL;
+	}
+
+	shm->info.shmaddr = shm->ximage->data = addr;
+	shm->info.readOnly = False;
+
+	/* XShmAttach fails asynchronously, e.g. for remote displays */
+	attach_error = FALSE;
+	handler = XSetErrorHandler(attach_error_handler);
+	XShmAttach(display, &shm->info);
+	XSync(display, False);
+	XSetErrorHandler(handler);
+
+	/* the segment is removed as soon as both sides detached */
+	shmctl(shm->info.shmid, IPC_RMID, NULL);
+
+	if (attach_error) {
+		xsg_message("XShmAttach failed, using XPutImage");
+		available = FALSE;
+		shmdt(addr);
+		destroy_ximage(shm->ximage);
+		xsg_free(shm);
+		return NULL;
+	}
+
+	shm_list = xsg_list_prepend(shm_list, shm);
+
+	return shm;
+}
+
+/******************************************************************************/
+
+static Bool
+is_completion(Display *dpy, XEvent *event, XPointer arg)
+{
+	xsg_shm_t *shm = (xsg_shm_t *) arg;
+
+	return event->type == completion_type
+		&& ((XShmCompletionEvent *) event)->shmseg == shm->info.shmseg;
+}
+
+/* Completion events are normally handled by xsg_shm_handle_event long
+ * before the next frame. Otherwise a single XSync makes sure all of them
+ * have arrived, a put that failed (e.g. BadMatch) never completes, so
+ * whatever is still pending after that is given up. */
+static void
+wait_completion(xsg_shm_t *shm)
+{
+	XEvent event;
+
+	while (shm->pending > 0 && XCheckIfEvent(display, &event,
+			is_completion, (XPointer) shm)) {
+		shm->pending--;
+	}
+
+	if (shm->pending == 0) {
+		return;
+	}
+
+	XSync(display, False);
+
+	while (shm->pending > 0 && XCheckIfEvent(display, &event,
+			is_completion, (XPointer) shm)) {
+		shm->pending--;
+	}
+
+	if (shm->pending > 0) {
+		xsg_warning("%u XShmPutImage requests did not complete",
+				shm->pending);
+		shm->pending = 0;
+	}
+}
+
+/* call before the first write of a frame */
+void
+xsg_shm_begin(xsg_shm_t *shm)
+{
+	wait_completion(shm);
+}
+
+/* the returned pixels may be written until the next xsg_shm_put of the
+ * same area */
+uint32_t *
+xsg_shm_get_data(xsg_shm_t *shm, unsigned *stride)
+{
+	*stride = shm->ximage->bytes_per_line / sizeof(uint32_t);
+
+	return (uint32_t *) shm->ximage->data;
+}
+
+void
+xsg_shm_copy(xsg_shm_t *shm, const uint32_t *data, int xoffset, int yoffset,
+		unsigned width, unsigned height)
+{
+	uint32_t *d;
+	unsigned stride, y;
+
+	d = xsg_shm_get_data(shm, &stride);
+	d += yoffset * stride + xoffset;
+
+	for (y = 0; y < height; y++) {
+		memcpy(d + y * stride, data + y * width,
+				width * sizeof(uint32_t));
+	}
+}
+
+void
+xsg_shm_put(xsg_shm_t *shm, Drawable drawable, int xoffset, int yoffset,
+		unsigned width, unsigned height)
+{
+	if (shm->gc == 0) {
+		XGCValues gcv;
+
+		gcv.graphics_exposures = False;
+		shm->gc = XCreateGC(display, drawable, GCGraphicsExposures,
+				&gcv);
+	}
+
+	XShmPutImage(display, drawable, shm->gc, shm->ximage,
+			xoffset, yoffset, xoffset, yoffset, width, height, True);
+
+	shm->pending++;
+}
+
+/******************************************************************************/
+
+bool
+xsg_shm_handle_event(XEvent *event)
+{
+	xsg_list_t *l;
+
+	if (completion_type == 0 || event->type != completion_type) {
+		return FALSE;
+	}
+
+	for (l = shm_list; l; l = l->next) {
+		xsg_shm_t *shm = l->data;
+
+		if (shm->info.shmseg == ((XShmCompletionEvent *) event)->shmseg
+				&& shm->pending > 0) {
+			shm->pending--;
+		}
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,61 @@
+/* shm.h
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SHM_H__
+#define __SHM_H__ 1
+
+#include <xsysguard.h>
+#include <X11/Xlib.h>
+
+/******************************************************************************/
+
+typedef struct _xsg_shm_t xsg_shm_t;
+
+/******************************************************************************/
+
+extern void
+xsg_shm_disable(void);
+
+extern void
+xsg_shm_init(Display *dpy);
+
+extern xsg_shm_t *
+xsg_shm_new(Visual *visual, unsigned depth, unsigned width, unsigned height);
+
+extern void
+xsg_shm_begin(xsg_shm_t *shm);
+
+extern uint32_t *
+xsg_shm_get_data(xsg_shm_t *shm, unsigned *stride);
+
+extern void
+xsg_shm_copy(xsg_shm_t *shm, const uint32_t *data, int xoffset, int yoffset,
+		unsigned width, unsigned height);
+
+extern void
+xsg_shm_put(xsg_shm_t *shm, Drawable drawable, int xoffset, int yoffset,
+		unsigned width, unsigned height);
+
+extern bool
+xsg_shm_handle_event(XEvent *event);
+
+/******************************************************************************/
+
+#endif /* __SHM_H__ */
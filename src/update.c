@@ -18,12 +18,41 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+/*
+ * Damage tracking: the damaged rectangles of a frame are kept as they are
+ * appended. Each rectangle is rendered and uploaded on its own, which costs
+ * about rect_cost pixels on top of its area, so pairs of rectangles are
+ * merged into their bounding box while that is cheaper or there are more
+ * than MAX_RECTS of them. The bounding box of all damage is used if it is
+ * cheaper than the remaining rectangles.
+ *
+ * If more than MAX_CANDIDATES rectangles are appended in one frame, the
+ * window is divided into tiles of TILE_SIZE x TILE_SIZE pixels instead, each
+ * tile keeps the bounding box of its damaged pixels. Appending a rectangle
+ * then only touches the tiles it covers and xsg_update_get_rects turns the
+ * damaged tiles into rectangles: runs of damaged tiles within a row of tiles,
+ * split where the damage does not cross a tile border and merged with the
+ * run directly above if it spans the same columns and touches.
+ */
+
 #include <xsysguard.h>
+#include <string.h>
+#include <limits.h>
 
 #include "update.h"
 
 /******************************************************************************/
 
+#define TILE_SHIFT 5
+#define TILE_SIZE (1 << TILE_SHIFT)
+
+#define MAX_RECTS 128
+
+/* rects before merging, tiles are used above this */
+#define MAX_CANDIDATES (2 * MAX_RECTS)
+
+/******************************************************************************/
+
 typedef struct _rect_t {
 	int xoffset;
 	int yoffset;
@@ -31,60 +60,591 @@ typedef struct _rect_t {
 	int height;
 } rect_t;
 
+/* damaged part of a tile in tile coordinates, x2 == 0: undamaged */
+typedef struct _box_t {
+	uint8_t x1;
+	uint8_t y1;
+	uint8_t x2;
+	uint8_t y2;
+} box_t;
+
+/* a run of damaged columns and the index of the rect it belongs to */
+typedef struct _run_t {
+	unsigned column1;
+	unsigned column2;
+	unsigned rect;
+} run_t;
+
+struct _xsg_update_t {
+	int width;
+	int height;
+
+	/* cost of one rect in pixels */
+	int64_t rect_cost;
+
+	/* the damage is kept in the tiles instead of rects */
+	bool tiled;
+	unsigned count;
+
+	unsigned columns;
+	unsigned rows;
+	box_t *tiles;
+
+	/* damaged columns of each row of tiles, one bit per tile */
+	unsigned words;
+	uint64_t *masks;
+	uint64_t *band_mask;
+
+	/* bounding box of all damage, x2 <= x1: no damage */
+	int x1;
+	int y1;
+	int x2;
+	int y2;
+
+	run_t *runs;
+	run_t *prev_runs;
+
+	/* rects and their cheapest merge partners */
+	rect_t *rects;
+	unsigned *partners;
+	int64_t *merge_costs;
+};
+
 /******************************************************************************/
 
+xsg_update_t *
+xsg_update_new(int width, int height, int rect_cost)
+{
+	xsg_update_t *update;
+
+	update = xsg_new(xsg_update_t, 1);
+
+	update->width = MAX(width, 1);
+	update->height = MAX(height, 1);
+
+	update->rect_cost = MAX(rect_cost, 0);
+
+	update->tiled = FALSE;
+	update->count = 0;
+
+	update->columns = (update->width + TILE_SIZE - 1) >> TILE_SHIFT;
+	update->rows = (update->height + TILE_SIZE - 1) >> TILE_SHIFT;
+	update->tiles = xsg_new0(box_t, update->columns * update->rows);
+
+	update->words = (update->columns + 63) / 64;
+	update->masks = xsg_new0(uint64_t, update->words * update->rows);
+	update->band_mask = xsg_new(uint64_t, update->words);
+
+	update->x1 = 0;
+	update->y1 = 0;
+	update->x2 = 0;
+	update->y2 = 0;
+
+	update->runs = xsg_new(run_t, update->columns);
+	update->prev_runs = xsg_new(run_t, update->columns);
+
+	update->rects = xsg_new(rect_t, MAX_CANDIDATES);
+	update->partners = xsg_new(unsigned, MAX_CANDIDATES);
+	update->merge_costs = xsg_new(int64_t, MAX_CANDIDATES);
+
+	return update;
+}
+
+bool
+xsg_update_is_empty(xsg_update_t *update)
+{
+	return update->x2 <= update->x1;
+}
+
+static void
+tiles_append(xsg_update_t *update, int x1, int y1, int x2, int y2)
+{
+	unsigned tx, ty;
+
+	for (ty = y1 >> TILE_SHIFT; ty <= (y2 - 1) >> TILE_SHIFT; ty++) {
+		int ty1 = MAX(y1 - (int) (ty << TILE_SHIFT), 0);
+		int ty2 = MIN(y2 - (int) (ty << TILE_SHIFT), TILE_SIZE);
+		box_t *box = update->tiles + ty * update->columns;
+		uint64_t *mask = update->masks + ty * update->words;
+
+		for (tx = x1 >> TILE_SHIFT; tx <= (x2 - 1) >> TILE_SHIFT; tx++) {
+			int tx1 = MAX(x1 - (int) (tx << TILE_SHIFT), 0);
+			int tx2 = MIN(x2 - (int) (tx << TILE_SHIFT), TILE_SIZE);
+
+			if (box[tx].x2 == 0) {
+				box[tx].x1 = tx1;
+				box[tx].y1 = ty1;
+				box[tx].x2 = tx2;
+				box[tx].y2 = ty2;
+				mask[tx / 64] |= 1ULL << (tx % 64);
+			} else {
+				box[tx].x1 = MIN(box[tx].x1, tx1);
+				box[tx].y1 = MIN(box[tx].y1, ty1);
+				box[tx].x2 = MAX(box[tx].x2, tx2);
+				box[tx].y2 = MAX(box[tx].y2, ty2);
+			}
+		}
+	}
+}
+
+void
+xsg_update_append_rect(xsg_update_t *update, int x, int y, int w, int h)
+{
+	int x1, y1, x2, y2;
+	unsigned i;
+
+	x1 = MAX(x, 0);
+	y1 = MAX(y, 0);
+	x2 = MIN(x + w, update->width);
+	y2 = MIN(y + h, update->height);
+
+	if (x2 <= x1 || y2 <= y1) {
+		return;
+	}
+
+	if (xsg_update_is_empty(update)) {
+		update->x1 = x1;
+		update->y1 = y1;
+		update->x2 = x2;
+		update->y2 = y2;
+	} else {
+		update->x1 = MIN(update->x1, x1);
+		update->y1 = MIN(update->y1, y1);
+		update->x2 = MAX(update->x2, x2);
+		update->y2 = MAX(update->y2, y2);
+	}
+
+	if (!update->tiled && update->count < MAX_CANDIDATES) {
+		rect_t *rect = update->rects + update->count++;
+
+		rect->xoffset = x1;
+		rect->yoffset = y1;
+		rect->width = x2 - x1;
+		rect->height = y2 - y1;
+		return;
+	}
+
+	if (!update->tiled) {
+		for (i = 0; i < update->count; i++) {
+			rect_t *rect = update->rects + i;
+
+			tiles_append(update, rect->xoffset, rect->yoffset,
+					rect->xoffset + rect->width,
+					rect->yoffset + rect->height);
+		}
+		update->tiled = TRUE;
+	}
+
+	tiles_append(update, x1, y1, x2, y2);
+}
+
+/******************************************************************************/
+
+static void
+rect_union(rect_t *rect, int x1, int y1, int x2, int y2)
+{
+	if (rect->width == 0) {
+		rect->xoffset = x1;
+		rect->yoffset = y1;
+		rect->width = x2 - x1;
+		rect->height = y2 - y1;
+		return;
+	}
+
+	x1 = MIN(x1, rect->xoffset);
+	y1 = MIN(y1, rect->yoffset);
+	x2 = MAX(x2, rect->xoffset + rect->width);
+	y2 = MAX(y2, rect->yoffset + rect->height);
+
+	rect->xoffset = x1;
+	rect->yoffset = y1;
+	rect->width = x2 - x1;
+	rect->height = y2 - y1;
+}
+
+/* damage of the tiles in rows [row1, row2) and columns [column1, column2) */
+static void
+band_union(
+	xsg_update_t *update,
+	rect_t *rect,
+	unsigned row1,
+	unsigned row2,
+	unsigned column1,
+	unsigned column2
+)
+{
+	unsigned tx, ty;
+
+	for (ty = row1; ty < row2; ty++) {
+		box_t *box = update->tiles + ty * update->columns;
+		int y = ty << TILE_SHIFT;
+
+		for (tx = column1; tx < column2; tx++) {
+			int x = tx << TILE_SHIFT;
+
+			if (box[tx].x2 == 0) {
+				continue;
+			}
+
+			rect_union(rect, x + box[tx].x1, y + box[tx].y1,
+					x + box[tx].x2, y + box[tx].y2);
+		}
+	}
+}
+
+/* first column >= column whose bit equals value, or columns */
+static unsigned
+find_bit(xsg_update_t *update, const uint64_t *mask, unsigned column,
+		bool value)
+{
+	while (column < update->columns) {
+		uint64_t word = mask[column / 64];
+
+		if (!value) {
+			word = ~word;
+		}
+
+		word &= ~0ULL << (column % 64);
+
+		if (word != 0) {
+			column = (column & ~63U) + __builtin_ctzll(word);
+			return MIN(column, update->columns);
+		}
+
+		column = (column & ~63U) + 64;
+	}
+
+	return update->columns;
+}
+
+/* last column of the run starting at column whose damage is contiguous */
+static unsigned
+find_gap(xsg_update_t *update, unsigned row, unsigned column,
+		unsigned column2)
+{
+	box_t *box = update->tiles + row * update->columns;
+
+	while (column + 1 < column2 && box[column].x2 == TILE_SIZE
+			&& box[column + 1].x1 == 0) {
+		column++;
+	}
+
+	return column;
+}
+
+/*
+ * Rectangles for bands of band tile rows. With band == 1 a run of damaged
+ * tiles is split where the damage does not cross the tile border and runs
+ * are only merged with the run above if their damage touches. Returns the
+ * number of rects or MAX_CANDIDATES + 1 if there are too many.
+ */
+static unsigned
+collect(xsg_update_t *update, unsigned band)
+{
+	unsigned row_first, row_last;
+	unsigned row, count = 0, prev_count = 0;
+
+	row_first = update->y1 >> TILE_SHIFT;
+	row_last = (update->y2 - 1) >> TILE_SHIFT;
+
+	for (row = row_first; row <= row_last; row += band) {
+		unsigned row2 = MIN(row + band, row_last + 1);
+		unsigned column, end, n = 0, p = 0, w, r;
+		run_t *tmp;
+
+		for (w = 0; w < update->words; w++) {
+			update->band_mask[w] = 0;
+			for (r = row; r < row2; r++) {
+				update->band_mask[w]
+					|= update->masks[r * update->words + w];
+			}
+		}
+
+		column = find_bit(update, update->band_mask, 0, TRUE);
+		end = find_bit(update, update->band_mask, column, FALSE);
+
+		while (column < update->columns) {
+			run_t *run = update->runs + n++;
+			rect_t rect = { 0, 0, 0, 0 };
+			int top = row << TILE_SHIFT;
+
+			run->column1 = column;
+
+			if (band == 1) {
+				run->column2 = find_gap(update, row, column,
+						end) + 1;
+			} else {
+				run->column2 = end;
+			}
+
+			if (run->column2 < end) {
+				column = run->column2;
+			} else {
+				column = find_bit(update, update->band_mask,
+						end, TRUE);
+				end = find_bit(update, update->band_mask,
+						column, FALSE);
+			}
+
+			band_union(update, &rect, row, row2, run->column1,
+					run->column2);
+
+			/* continue the rect of the band above */
+			while (p < prev_count && update->prev_runs[p].column1
+					< run->column1) {
+				p++;
+			}
+
+			if (p < prev_count
+			 && update->prev_runs[p].column1 == run->column1
+			 && update->prev_runs[p].column2 == run->column2
+			 && (band > 1 || (rect.yoffset == top
+			  && update->rects[update->prev_runs[p].rect].yoffset
+			   + update->rects[update->prev_runs[p].rect].height
+			   == top))) {
+				run->rect = update->prev_runs[p].rect;
+				rect_union(update->rects + run->rect,
+						rect.xoffset, rect.yoffset,
+						rect.xoffset + rect.width,
+						rect.yoffset + rect.height);
+			} else if (count < MAX_CANDIDATES) {
+				run->rect = count;
+				update->rects[count++] = rect;
+			} else {
+				return MAX_CANDIDATES + 1;
+			}
+		}
+
+		tmp = update->prev_runs;
+		update->prev_runs = update->runs;
+		update->runs = tmp;
+		prev_count = n;
+	}
+
+	return count;
+}
+
+/******************************************************************************/
+
+static int64_t
+area(const rect_t *rect)
+{
+	return (int64_t) rect->width * rect->height;
+}
+
+/* cost of uploading the bounding box of a and b instead of both */
+static int64_t
+merge_cost(xsg_update_t *update, const rect_t *a, const rect_t *b)
+{
+	rect_t rect = *a;
+
+	rect_union(&rect, b->xoffset, b->yoffset, b->xoffset + b->width,
+			b->yoffset + b->height);
+
+	return area(&rect) - area(a) - area(b) - update->rect_cost;
+}
+
+static void
+find_partner(xsg_update_t *update, unsigned count, unsigned i)
+{
+	unsigned j;
+
+	update->partners[i] = i;
+	update->merge_costs[i] = INT64_MAX;
+
+	for (j = 0; j < count; j++) {
+		int64_t c;
+
+		if (j == i) {
+			continue;
+		}
+
+		c = merge_cost(update, update->rects + i, update->rects + j);
+
+		if (c < update->merge_costs[i]) {
+			update->partners[i] = j;
+			update->merge_costs[i] = c;
+		}
+	}
+}
+
+/*
+ * Greedily merges the pair of rects with the lowest merge cost while that
+ * saves something or there are more than MAX_RECTS rects. Each rect keeps
+ * its cheapest partner, so a merge only rescans the rects whose partner
+ * was one of the merged ones. Returns the new number of rects.
+ */
+static unsigned
+merge(xsg_update_t *update, unsigned count)
+{
+	rect_t *rects = update->rects;
+	unsigned *partners = update->partners;
+	int64_t *costs = update->merge_costs;
+	unsigned i, k;
+
+	for (i = 0; i < count; i++) {
+		partners[i] = i;
+		costs[i] = INT64_MAX;
+	}
+
+	for (i = 0; i < count; i++) {
+		for (k = i + 1; k < count; k++) {
+			int64_t c = merge_cost(update, rects + i, rects + k);
+
+			if (c < costs[i]) {
+				partners[i] = k;
+				costs[i] = c;
+			}
+			if (c < costs[k]) {
+				partners[k] = i;
+				costs[k] = c;
+			}
+		}
+	}
+
+	while (count > 1) {
+		unsigned keep, drop, last;
+
+		for (i = 0, k = 1; k < count; k++) {
+			if (costs[k] < costs[i]) {
+				i = k;
+			}
+		}
+
+		if (costs[i] > 0 && count <= MAX_RECTS) {
+			break;
+		}
+
+		keep = MIN(i, partners[i]);
+		drop = MAX(i, partners[i]);
+		last = count - 1;
+
+		rect_union(rects + keep, rects[drop].xoffset,
+				rects[drop].yoffset,
+				rects[drop].xoffset + rects[drop].width,
+				rects[drop].yoffset + rects[drop].height);
+
+		for (k = 0; k < count; k++) {
+			if (partners[k] == keep || partners[k] == drop) {
+				partners[k] = UINT_MAX;
+			}
+		}
+
+		rects[drop] = rects[last];
+		partners[drop] = partners[last];
+		costs[drop] = costs[last];
+		count--;
+
+		for (k = 0; k < count; k++) {
+			if (partners[k] == last) {
+				partners[k] = drop;
+			}
+		}
+
+		partners[keep] = keep;
+		costs[keep] = INT64_MAX;
+
+		for (k = 0; k < count; k++) {
+			int64_t c;
+
+			if (k == keep) {
+				continue;
+			}
+
+			if (partners[k] == UINT_MAX) {
+				find_partner(update, count, k);
+			}
+
+			c = merge_cost(update, rects + k, rects + keep);
+
+			if (c < costs[k]) {
+				partners[k] = keep;
+				costs[k] = c;
+			}
+			if (c < costs[keep]) {
+				partners[keep] = k;
+				costs[keep] = c;
+			}
+		}
+	}
+
+	return count;
+}
+
 xsg_list_t *
-xsg_update_append_rect(xsg_list_t *updates, int x, int y, int w, int h)
+xsg_update_get_rects(xsg_update_t *update)
 {
-	int x1_1, x2_1, y1_1, y2_1;
-	xsg_list_t *l;
-	rect_t *rect;
+	xsg_list_t *rects = NULL;
+	uint64_t bounding_cost, sum = 0;
+	unsigned band, count, row, i;
 
-	if (w < 1 || h < 1) {
-		return updates;
+	if (xsg_update_is_empty(update)) {
+		return NULL;
 	}
 
-	x1_1 = x;
-	x2_1 = x + w;
-	y1_1 = y;
-	y2_1 = y + h;
+	if (update->tiled) {
+		for (band = 1; ; band *= 2) {
+			count = collect(update, band);
 
-	for (l = updates; l; l = l->next) {
-		int x1_2, x2_2, y1_2, y2_2;
-		bool x_overlap, y_overlap;
+			if (count <= MAX_CANDIDATES || band >= update->rows) {
+				break;
+			}
+		}
+	} else {
+		count = update->count;
+	}
+
+	if (count <= MAX_CANDIDATES) {
+		count = merge(update, count);
+	}
+
+	for (i = 0; i < count && count <= MAX_RECTS; i++) {
+		sum += update->rect_cost + area(update->rects + i);
+	}
+
+	bounding_cost = update->rect_cost + (uint64_t) (update->x2 - update->x1)
+		* (update->y2 - update->y1);
 
-		rect = l->data;
+	if (count > MAX_RECTS || bounding_cost <= sum) {
+		rect_t *rect;
 
-		x1_2 = rect->xoffset;
-		x2_2 = rect->xoffset + rect->width;
-		y1_2 = rect->yoffset;
-		y2_2 = rect->yoffset + rect->height;
+		rect = xsg_new(rect_t, 1);
+		rect->xoffset = update->x1;
+		rect->yoffset = update->y1;
+		rect->width = update->x2 - update->x1;
+		rect->height = update->y2 - update->y1;
 
-		x_overlap = !((x2_2 <= x1_1) || (x2_1 <= x1_2));
-		y_overlap = !((y2_2 <= y1_1) || (y2_1 <= y1_2));
+		rects = xsg_list_prepend(NULL, rect);
+	} else {
+		for (i = 0; i < count; i++) {
+			rect_t *rect = xsg_new(rect_t, 1);
 
-		if (x_overlap && y_overlap) {
-			xsg_free(rect);
-			updates = xsg_list_delete_link(updates, l);
-			x = MIN(x1_1, x1_2);
-			y = MIN(y1_1, y1_2);
-			w = MAX(x2_1, x2_2) - x;
-			h = MAX(y2_1, y2_2) - y;
-			return xsg_update_append_rect(updates, x, y, w, h);
+			*rect = update->rects[i];
+			rects = xsg_list_prepend(rects, rect);
 		}
 	}
 
-	rect = xsg_new(rect_t, 1);
-	rect->xoffset = x;
-	rect->yoffset = y;
-	rect->width = w;
-	rect->height = h;
+	for (row = update->y1 >> TILE_SHIFT; update->tiled
+	     && row <= (update->y2 - 1) >> TILE_SHIFT; row++) {
+		memset(update->tiles + row * update->columns, 0,
+				update->columns * sizeof(box_t));
+		memset(update->masks + row * update->words, 0,
+				update->words * sizeof(uint64_t));
+	}
+
+	update->tiled = FALSE;
+	update->count = 0;
 
-	updates = xsg_list_prepend(updates, rect);
+	update->x1 = 0;
+	update->y1 = 0;
+	update->x2 = 0;
+	update->y2 = 0;
 
-	return updates;
+	return rects;
 }
 
+/******************************************************************************/
+
 void
 xsg_update_get_coordinates(xsg_list_t *updates, int *x, int *y, int *w, int *h) {
 	rect_t *rect;
@@ -123,4 +683,3 @@ void xsg_update_free(xsg_list_t *updates) {
 	xsg_list_free(updates);
 }
 
-
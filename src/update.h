@@ -25,8 +25,21 @@
 
 /******************************************************************************/
 
+typedef struct _xsg_update_t xsg_update_t;
+
+/******************************************************************************/
+
+extern xsg_update_t *
+xsg_update_new(int width, int height, int rect_cost);
+
+extern bool
+xsg_update_is_empty(xsg_update_t *update);
+
+extern void
+xsg_update_append_rect(xsg_update_t *update, int x, int y, int w, int h);
+
 extern xsg_list_t *
-xsg_update_append_rect(xsg_list_t *updates, int x, int y, int w, int h);
+xsg_update_get_rects(xsg_update_t *update);
 
 extern void
 xsg_update_get_coordinates(xsg_list_t * updates, int *x, int *y, int *w, int *h);
@@ -23,6 +23,7 @@
 #include <math.h>
 
 #include "window.h"
+#include "widget.h"
 #include "modules.h"
 #include "var.h"
 #include "rpn.h"
@@ -34,13 +35,17 @@ struct _xsg_var_t {
 	xsg_widget_t *widget;
 	xsg_rpn_t *rpn;
 	bool dirty;
+	xsg_var_t *next_dirty;
 };
 
 /******************************************************************************/
 
 static xsg_list_t *var_list = NULL;
+static xsg_list_t *var_list_last = NULL;
 
-static bool dirty = FALSE;
+/* dirty vars in the order they became dirty, linked through next_dirty */
+static xsg_var_t *dirty_head = NULL;
+static xsg_var_t *dirty_tail = NULL;
 
 /******************************************************************************/
 
@@ -51,30 +56,45 @@ xsg_var_dirty(xsg_var_t *var)
 		return;
 	}
 
+	if (var->dirty) {
+		return;
+	}
+
 	var->dirty = TRUE;
+	var->next_dirty = NULL;
 
-	dirty = TRUE;
+	if (dirty_tail == NULL) {
+		dirty_head = var;
+	} else {
+		dirty_tail->next_dirty = var;
+	}
+
+	dirty_tail = var;
 }
 
 void
 xsg_var_flush_dirty(void)
 {
-	if (dirty) {
-		xsg_list_t *l;
+	xsg_var_t *var;
 
-		for (l = var_list; l; l = l->next) {
-			xsg_var_t *var = l->data;
+	if (dirty_head == NULL) {
+		return;
+	}
 
-			if (!var->dirty) {
-				continue;
-			}
+	while ((var = dirty_head) != NULL) {
+		dirty_head = var->next_dirty;
 
-			xsg_window_update_var(var->window, var->widget, var);
-			var->dirty = FALSE;
+		if (dirty_head == NULL) {
+			dirty_tail = NULL;
 		}
-		xsg_window_render();
-		dirty = FALSE;
+
+		var->dirty = FALSE;
+		var->next_dirty = NULL;
+
+		xsg_window_update_var(var->window, var->widget, var);
 	}
+
+	xsg_window_render();
 }
 
 /******************************************************************************/
@@ -92,9 +112,14 @@ xsg_var_parse_num(uint64_t update, xsg_window_t *window, xsg_widget_t *widget)
 	var->window = window;
 	var->widget = widget;
 	var->dirty = FALSE;
+	var->next_dirty = NULL;
 	var->rpn = rpn;
 
-	var_list = xsg_list_append(var_list, var);
+	var_list = xsg_list_append_last(var_list, &var_list_last, var);
+
+	if (widget != NULL) {
+		widget->var_list = xsg_list_append(widget->var_list, var);
+	}
 
 	return var;
 }
@@ -112,9 +137,39 @@ xsg_var_parse_str(uint64_t update, xsg_window_t *window, xsg_widget_t *widget)
 	var->window = window;
 	var->widget = widget;
 	var->dirty = FALSE;
+	var->next_dirty = NULL;
 	var->rpn = rpn;
 
-	var_list = xsg_list_append(var_list, var);
+	var_list = xsg_list_append_last(var_list, &var_list_last, var);
+
+	if (widget != NULL) {
+		widget->var_list = xsg_list_append(widget->var_list, var);
+	}
+
+	return var;
+}
+
+xsg_var_t *
+xsg_var_parse_vec(uint64_t update, xsg_window_t *window, xsg_widget_t *widget)
+{
+	xsg_var_t *var;
+	xsg_rpn_t *rpn;
+
+	var = xsg_new(xsg_var_t, 1);
+
+	rpn = xsg_rpn_parse_vec(update, var);
+
+	var->window = window;
+	var->widget = widget;
+	var->dirty = FALSE;
+	var->next_dirty = NULL;
+	var->rpn = rpn;
+
+	var_list = xsg_list_append_last(var_list, &var_list_last, var);
+
+	if (widget != NULL) {
+		widget->var_list = xsg_list_append(widget->var_list, var);
+	}
 
 	return var;
 }
@@ -125,9 +180,30 @@ xsg_var_get_num(xsg_var_t *var)
 	return xsg_rpn_get_num(var->rpn);
 }
 
-char *
+const char *
 xsg_var_get_str(xsg_var_t *var)
 {
 	return xsg_rpn_get_str(var->rpn);
 }
 
+const double *
+xsg_var_get_vec(xsg_var_t *var, unsigned *len)
+{
+	return xsg_rpn_get_vec(var->rpn, len);
+}
+
+/* FALSE if none of the inputs of the var changed since the last call, the
+ * value would then be the same as the last time */
+bool
+xsg_var_changed(xsg_var_t *var)
+{
+	return xsg_rpn_changed(var->rpn);
+}
+
+/* restart the time-series ops of the var, e.g. after it was not sampled for
+ * a while */
+void
+xsg_var_reset(xsg_var_t *var)
+{
+	xsg_rpn_reset(var->rpn);
+}
@@ -41,12 +41,24 @@ xsg_var_parse_num(uint64_t update, xsg_window_t *window, xsg_widget_t *widget);
 extern xsg_var_t *
 xsg_var_parse_str(uint64_t update, xsg_window_t *window, xsg_widget_t *widget);
 
+extern xsg_var_t *
+xsg_var_parse_vec(uint64_t update, xsg_window_t *window, xsg_widget_t *widget);
+
 extern double
 xsg_var_get_num(xsg_var_t *var);
 
-extern char *
+extern const char *
 xsg_var_get_str(xsg_var_t *var);
 
+extern const double *
+xsg_var_get_vec(xsg_var_t *var, unsigned *len);
+
+extern bool
+xsg_var_changed(xsg_var_t *var);
+
+extern void
+xsg_var_reset(xsg_var_t *var);
+
 /*****************************************************************************/
 
 #endif /* __VAR_H__ */
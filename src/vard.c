@@ -48,13 +48,21 @@ struct _xsg_var_t {
 	double num;
 
 	xsg_rpn_t *rpn;
+
+	xsg_var_t *next_dirty;
 };
 
 /******************************************************************************/
 
 static xsg_list_t *var_list = NULL;
+static xsg_list_t *var_list_last = NULL;
+
+/* changed vars in the order they changed, linked through next_dirty */
+static xsg_var_t *dirty_head = NULL;
+static xsg_var_t *dirty_tail = NULL;
 
-static bool dirty = FALSE;
+/* the alive message needs to be flushed */
+static bool flush = FALSE;
 
 /******************************************************************************/
 
@@ -66,9 +74,9 @@ static uint64_t last_alive_timeout = 8;
 void
 xsg_vard_queue_vars(void)
 {
-	xsg_list_t *l;
+	xsg_var_t *var;
 
-	if (!dirty) {
+	if (dirty_head == NULL && !flush) {
 		return;
 	}
 
@@ -76,12 +84,9 @@ xsg_vard_queue_vars(void)
 		return;
 	}
 
-	for (l = var_list; l; l = l->next) {
-		xsg_var_t *var = l->data;
-
-		if (!var->dirty) {
-			continue;
-		}
+	while ((var = dirty_head) != NULL) {
+		dirty_head = var->next_dirty;
+		var->next_dirty = NULL;
 
 		if (var->type == NUM) {
 			xsg_writebuffer_queue_num(var->remote_id, var->num);
@@ -94,13 +99,32 @@ xsg_vard_queue_vars(void)
 		var->dirty = FALSE;
 	}
 
-	dirty = FALSE;
+	dirty_tail = NULL;
+	flush = FALSE;
 
 	xsg_writebuffer_flush();
 }
 
 /******************************************************************************/
 
+static void
+set_dirty(xsg_var_t *var)
+{
+	if (var->dirty) {
+		return;
+	}
+
+	var->dirty = TRUE;
+
+	if (dirty_tail == NULL) {
+		dirty_head = var;
+	} else {
+		dirty_tail->next_dirty = var;
+	}
+
+	dirty_tail = var;
+}
+
 static void
 update_var(xsg_var_t *var)
 {
@@ -113,18 +137,16 @@ update_var(xsg_var_t *var)
 #endif
 		if (num != var->num) {
 			var->num = num;
-			var->dirty = TRUE;
-			dirty = TRUE;
+			set_dirty(var);
 		}
 	} else if (var->type == STR) {
-		char *str;
+		const char *str;
 
 		str = xsg_rpn_get_str(var->rpn);
 
 		if (strcmp(str, var->str->str) != 0) {
 			xsg_string_assign(var->str, str);
-			var->dirty = TRUE;
-			dirty = TRUE;
+			set_dirty(var);
 		}
 	} else {
 		xsg_error("invalid var type");
@@ -145,7 +167,7 @@ update_vard(uint64_t tick)
 
 	xsg_writebuffer_queue_alive();
 
-	dirty = TRUE;
+	flush = TRUE;
 
 	for (l = var_list; l; l = l->next) {
 		xsg_var_t *var = l->data;
@@ -197,6 +219,7 @@ xsg_vard_parse(uint8_t type, uint32_t remote_id, uint64_t update)
 	var->update = (update == 0) ? UINT64_MAX : update;
 	var->remote_id = remote_id;
 	var->dirty = FALSE;
+	var->next_dirty = NULL;
 	var->type = type;
 	var->rpn = rpn;
 	var->num = DNAN;
@@ -209,7 +232,7 @@ xsg_vard_parse(uint8_t type, uint32_t remote_id, uint64_t update)
 		xsg_error("invalid var type");
 	}
 
-	var_list = xsg_list_append(var_list, var);
+	var_list = xsg_list_append_last(var_list, &var_list_last, var);
 }
 
 /******************************************************************************/
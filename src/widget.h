@@ -25,6 +25,7 @@
 #include <Imlib2.h>
 
 #include "window.h"
+#include "profile.h"
 
 /*****************************************************************************/
 
@@ -45,8 +46,14 @@ struct _xsg_widget_t {
 	void (*render_func)(xsg_widget_t *widget, Imlib_Image buffer, int x, int y);
 	void (*update_func)(xsg_widget_t *widget, xsg_var_t *var);
 	void (*scroll_func)(xsg_widget_t *widget);
+	void (*skip_func)(xsg_widget_t *widget);	/* update while hidden */
 
 	void *data;
+
+	xsg_list_t *var_list;	/* all vars of the widget */
+	bool update_on_change;	/* update_func only depends on var_list */
+
+	xsg_profile_t *profile;
 };
 
 /******************************************************************************/
@@ -896,6 +896,32 @@ scroll_areachart(xsg_widget_t *widget)
 			widget->yoffset, widget->width, widget->height);
 }
 
+/* the hidden chart keeps moving, without sampling its vars: the skipped
+ * updates are shown as gaps once the chart is visible again */
+static void
+skip_areachart(xsg_widget_t *widget)
+{
+	areachart_t *areachart;
+	xsg_list_t *l;
+	unsigned int width;
+
+	areachart = (areachart_t *) widget->data;
+
+	if (areachart->angle) {
+		width = areachart->angle->width;
+	} else {
+		width = widget->width;
+	}
+
+	areachart->value_index = (areachart->value_index + 1) % width;
+
+	for (l = areachart->var_list; l; l = l->next) {
+		areachart_var_t *areachart_var = l->data;
+
+		areachart_var->values[areachart->value_index] = DNAN;
+	}
+}
+
 /******************************************************************************/
 
 static void
@@ -1000,6 +1026,7 @@ xsg_widget_areachart_parse(xsg_window_t *window)
 	widget->render_func = render_areachart;
 	widget->update_func = update_areachart;
 	widget->scroll_func = scroll_areachart;
+	widget->skip_func = skip_areachart;
 	widget->data = (void *) areachart;
 
 	areachart->angle = NULL;
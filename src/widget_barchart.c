@@ -21,6 +21,7 @@
 #include <xsysguard.h>
 #include <math.h>
 #include <float.h>
+#include <string.h>
 
 #include "widgets.h"
 #include "widget.h"
@@ -39,6 +40,9 @@ typedef struct {
 	double range_angle;
 	bool add_prev;
 	double value;
+	double *values;		/* Vector: one value per column */
+	unsigned len;
+	unsigned size;
 } barchart_var_t;
 
 /******************************************************************************/
@@ -51,12 +55,14 @@ typedef struct {
 	xsg_var_t *max_var;
 	char *mask;
 	xsg_list_t *var_list;
+	bool vector;		/* one column of bars per vector element */
+	unsigned columns;
 } barchart_t;
 
 /******************************************************************************/
 
 static void
-render_barchart(xsg_widget_t *widget, Imlib_Image buffer, int up_x, int up_y)
+render_bars(xsg_widget_t *widget, Imlib_Image buffer, int up_x, int up_y)
 {
 	barchart_t *barchart;
 	xsg_list_t *l;
@@ -598,6 +604,196 @@ render_barchart(xsg_widget_t *widget, Imlib_Image buffer, int up_x, int up_y)
 	}
 }
 
+/* each column is rendered like a barchart of its own, the columns follow
+ * the angle of the bars */
+
+static void
+render_barchart(xsg_widget_t *widget, Imlib_Image buffer, int up_x, int up_y)
+{
+	barchart_t *barchart;
+	int xoffset, yoffset;
+	unsigned int width, height;
+	bool horizontal = FALSE;
+	bool reverse = FALSE;
+	unsigned i;
+
+	barchart = (barchart_t *) widget->data;
+
+	if (!barchart->vector) {
+		render_bars(widget, buffer, up_x, up_y);
+		return;
+	}
+
+	if (barchart->angle != NULL) {
+		horizontal = (barchart->angle->angle == 90.0)
+			|| (barchart->angle->angle == 270.0);
+		reverse = (barchart->angle->angle == 180.0)
+			|| (barchart->angle->angle == 270.0);
+	}
+
+	xoffset = widget->xoffset;
+	yoffset = widget->yoffset;
+	width = widget->width;
+	height = widget->height;
+
+	for (i = 0; i < barchart->columns; i++) {
+		unsigned column = reverse ? barchart->columns - 1 - i : i;
+		xsg_list_t *l;
+
+		for (l = barchart->var_list; l; l = l->next) {
+			barchart_var_t *barchart_var = l->data;
+
+			if (column < barchart_var->len) {
+				barchart_var->value = barchart_var->values[column];
+			} else {
+				barchart_var->value = DNAN;
+			}
+		}
+
+		if (horizontal) {
+			unsigned int start = (height * i) / barchart->columns;
+			unsigned int end = (height * (i + 1)) / barchart->columns;
+
+			widget->yoffset = yoffset + start;
+			widget->height = end - start;
+		} else {
+			unsigned int start = (width * i) / barchart->columns;
+			unsigned int end = (width * (i + 1)) / barchart->columns;
+
+			widget->xoffset = xoffset + start;
+			widget->width = end - start;
+		}
+
+		if (widget->width > 0 && widget->height > 0) {
+			render_bars(widget, buffer, up_x, up_y);
+		}
+	}
+
+	widget->xoffset = xoffset;
+	widget->yoffset = yoffset;
+	widget->width = width;
+	widget->height = height;
+}
+
+static void
+update_barchart_vector(xsg_widget_t *widget, xsg_var_t *var)
+{
+	barchart_t *barchart;
+	xsg_list_t *l;
+	unsigned columns = 0;
+	unsigned i;
+	bool dirty = FALSE;
+
+	barchart = (barchart_t *) widget->data;
+
+	if (barchart->min_var && ((var == NULL) || (barchart->min_var == var))) {
+		double value = barchart->min;
+
+		barchart->min = xsg_var_get_num(barchart->min_var);
+		if (value != barchart->min) {
+			dirty = TRUE;
+		}
+	}
+	if (barchart->max_var && ((var == NULL) || (barchart->max_var == var))) {
+		double value = barchart->max;
+
+		barchart->max = xsg_var_get_num(barchart->max_var);
+		if (value != barchart->max) {
+			dirty = TRUE;
+		}
+	}
+
+	for (l = barchart->var_list; l; l = l->next) {
+		barchart_var_t *barchart_var = l->data;
+
+		if ((var == NULL) || (barchart_var->var == var)) {
+			const double *values;
+			unsigned len;
+
+			values = xsg_var_get_vec(barchart_var->var, &len);
+
+			if (len > barchart_var->size) {
+				barchart_var->values = xsg_renew(double,
+						barchart_var->values, len);
+				barchart_var->size = len;
+			}
+
+			if (len != barchart_var->len || memcmp(barchart_var->values,
+					values, sizeof(double) * len) != 0) {
+				memcpy(barchart_var->values, values,
+						sizeof(double) * len);
+				barchart_var->len = len;
+				dirty = TRUE;
+			}
+		}
+
+		columns = MAX(columns, barchart_var->len);
+	}
+
+	barchart->columns = columns;
+
+	if (barchart->min_var && barchart->max_var) {
+		;
+	} else {
+		if (!barchart->min_var) {
+			barchart->min = DBL_MAX;
+		}
+		if (!barchart->max_var) {
+			barchart->max = - DBL_MAX;
+		}
+
+		for (i = 0; i < columns; i++) {
+			double pos = 0.0;
+			double neg = 0.0;
+
+			for (l = barchart->var_list; l; l = l->next) {
+				barchart_var_t *barchart_var = l->data;
+				double value = DNAN;
+				double m;
+
+				if (i < barchart_var->len) {
+					value = barchart_var->values[i];
+				}
+
+				if (value > 0.0) {
+					if (barchart_var->add_prev) {
+						pos += value;
+					} else {
+						pos = value;
+					}
+					m = pos;
+				} else if (value < 0.0) {
+					if (barchart_var->add_prev) {
+						neg += value;
+					} else {
+						neg = value;
+					}
+					m = neg;
+				} else {
+					if (!barchart_var->add_prev) {
+						pos = 0.0;
+						neg = 0.0;
+					}
+					m = 0.0;
+				}
+
+				if (!barchart->min_var) {
+					barchart->min = MIN(barchart->min, m);
+				}
+				if (!barchart->max_var) {
+					barchart->max = MAX(barchart->max, m);
+				}
+			}
+		}
+	}
+
+	if (dirty) {
+		xsg_window_update_append_rect(widget->window,
+				widget->xoffset, widget->yoffset,
+				widget->width, widget->height);
+	}
+}
+
 static void
 update_barchart(xsg_widget_t *widget, xsg_var_t *var)
 {
@@ -608,6 +804,11 @@ update_barchart(xsg_widget_t *widget, xsg_var_t *var)
 
 	barchart = (barchart_t *) widget->data;
 
+	if (barchart->vector) {
+		update_barchart_vector(widget, var);
+		return;
+	}
+
 	if (barchart->min_var && barchart->max_var) {
 		if ((var == NULL) || (barchart->min_var == var)) {
 			double value = barchart->min;
@@ -815,6 +1016,9 @@ parse_var(xsg_widget_t *widget, xsg_var_t *var)
 	barchart_var->range_angle = 0.0;
 	barchart_var->add_prev = FALSE;
 	barchart_var->value = DNAN;
+	barchart_var->values = NULL;
+	barchart_var->len = 0;
+	barchart_var->size = 0;
 
 	while (!xsg_conf_find_newline()) {
 		if (xsg_conf_find_command("ColorRange")) {
@@ -874,6 +1078,7 @@ xsg_widget_barchart_parse(xsg_window_t *window)
 	widget->height = xsg_conf_read_uint();
 	widget->render_func = render_barchart;
 	widget->update_func = update_barchart;
+	widget->update_on_change = TRUE;
 	widget->scroll_func = scroll_barchart;
 	widget->data = (void *) barchart;
 
@@ -884,6 +1089,8 @@ xsg_widget_barchart_parse(xsg_window_t *window)
 	barchart->max_var = NULL;
 	barchart->mask = NULL;
 	barchart->var_list = NULL;
+	barchart->vector = FALSE;
+	barchart->columns = 0;
 
 	while (!xsg_conf_find_newline()) {
 		if (xsg_conf_find_command("Visible")) {
@@ -903,19 +1110,49 @@ xsg_widget_barchart_parse(xsg_window_t *window)
 				xsg_free(barchart->mask);
 			}
 			barchart->mask = xsg_conf_read_string();
+		} else if (xsg_conf_find_command("Vector")) {
+			barchart->vector = TRUE;
 		} else {
-			xsg_conf_error("Visible, Angle, Min, Max or Mask "
-					"expected");
+			xsg_conf_error("Visible, Angle, Min, Max, Mask or "
+					"Vector expected");
 		}
 	}
 
+	/* Angle 360 or -90 is the same as 0 or 270 */
+	angle = fmod(angle, 360.0);
+
+	if (angle < 0.0) {
+		angle += 360.0;
+	}
+
 	if (angle != 0.0) {
 		barchart->angle = xsg_angle_parse(angle, widget->xoffset,
 				widget->yoffset, widget->width, widget->height);
 	}
 
+	if (barchart->vector) {
+		if (barchart->mask != NULL) {
+			xsg_conf_error("BarChart: Vector and Mask cannot be "
+					"combined");
+		}
+		if (barchart->angle != NULL
+				&& barchart->angle->angle != 0.0
+				&& barchart->angle->angle != 90.0
+				&& barchart->angle->angle != 180.0
+				&& barchart->angle->angle != 270.0) {
+			xsg_conf_error("BarChart: Vector needs an Angle of "
+					"0, 90, 180 or 270");
+		}
+	}
+
 	while (xsg_conf_find_command("+")) {
-		parse_var(widget, xsg_var_parse_num(widget->update, window, widget));
+		if (barchart->vector) {
+			parse_var(widget, xsg_var_parse_vec(widget->update,
+					window, widget));
+		} else {
+			parse_var(widget, xsg_var_parse_num(widget->update,
+					window, widget));
+		}
 	}
 }
 
@@ -132,6 +132,7 @@ xsg_widget_image_parse(xsg_window_t *window)
 	widget->height = xsg_conf_read_uint();
 	widget->render_func = render_image;
 	widget->update_func = update_image;
+	widget->update_on_change = TRUE;
 	widget->scroll_func = scroll_image;
 	widget->data = (void *) image;
 
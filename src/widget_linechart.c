@@ -544,6 +544,32 @@ scroll_linechart(xsg_widget_t *widget)
 			widget->width, widget->height);
 }
 
+/* the hidden chart keeps moving, without sampling its vars: the skipped
+ * updates are shown as gaps once the chart is visible again */
+static void
+skip_linechart(xsg_widget_t *widget)
+{
+	linechart_t *linechart;
+	xsg_list_t *l;
+	unsigned int width;
+
+	linechart = (linechart_t *) widget->data;
+
+	if (linechart->angle) {
+		width = linechart->angle->width;
+	} else {
+		width = widget->width;
+	}
+
+	linechart->value_index = (linechart->value_index + 1) % width;
+
+	for (l = linechart->var_list; l; l = l->next) {
+		linechart_var_t *linechart_var = l->data;
+
+		linechart_var->values[linechart->value_index] = DNAN;
+	}
+}
+
 /******************************************************************************/
 
 static void
@@ -593,6 +619,7 @@ xsg_widget_linechart_parse(xsg_window_t *window)
 	widget->render_func = render_linechart;
 	widget->update_func = update_linechart;
 	widget->scroll_func = scroll_linechart;
+	widget->skip_func = skip_linechart;
 	widget->data = (void *) linechart;
 
 	linechart->angle = NULL;
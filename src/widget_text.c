@@ -707,6 +707,7 @@ xsg_widget_text_parse(xsg_window_t *window)
 	widget->height = xsg_conf_read_uint();
 	widget->render_func = render_text;
 	widget->update_func = update_text;
+	widget->update_on_change = TRUE;
 	widget->scroll_func = scroll_text;
 	widget->data = (void *) text;
 
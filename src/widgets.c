@@ -25,10 +25,12 @@
 #include "window.h"
 #include "imlib.h"
 #include "var.h"
+#include "conf.h"
 
 /******************************************************************************/
 
 static xsg_list_t *widget_list = NULL;
+static xsg_list_t *widget_list_last = NULL;
 
 /******************************************************************************/
 
@@ -49,9 +51,21 @@ xsg_widget_t *xsg_widgets_new(xsg_window_t *window) {
 	widget->render_func = NULL;
 	widget->update_func = NULL;
 	widget->scroll_func = NULL;
+	widget->skip_func = NULL;
 	widget->data = NULL;
+	widget->var_list = NULL;
+	widget->update_on_change = FALSE;
+	widget->profile = NULL;
 
-	widget_list = xsg_list_append(widget_list, widget);
+	if (xsg_profile_enabled) {
+		char *location = xsg_conf_get_location();
+
+		widget->profile = xsg_profile_new("render", location);
+		xsg_free(location);
+	}
+
+	widget_list = xsg_list_append_last(widget_list, &widget_list_last,
+			widget);
 
 	xsg_window_add_widget(window, widget);
 
@@ -99,7 +113,14 @@ xsg_widgets_render(
 	xsg_widget_t *widget = w;
 
 	if (widget->visible && widget_rect(widget, up_x, up_y, up_w, up_h)) {
-		(widget->render_func)(widget, buffer, up_x, up_y);
+		if (unlikely(widget->profile != NULL)) {
+			uint64_t start = xsg_profile_start();
+
+			(widget->render_func)(widget, buffer, up_x, up_y);
+			xsg_profile_stop(widget->profile, start);
+		} else {
+			(widget->render_func)(widget, buffer, up_x, up_y);
+		}
 	}
 }
 
@@ -109,6 +130,48 @@ xsg_widgets_render(
  *
  ******************************************************************************/
 
+/* hidden widgets and widgets of unmapped windows do not sample their vars,
+ * only their visible var is evaluated while the window is mapped */
+
+static bool
+is_shown(xsg_widget_t *widget)
+{
+	return widget->visible && xsg_window_is_visible(widget->window);
+}
+
+/* a widget shown again catches up with its vars right away instead of at
+ * its next update, the time-series ops of its vars start over so that the
+ * hidden period does not show up as one large difference */
+static void
+catch_up(xsg_widget_t *widget)
+{
+	xsg_list_t *l;
+
+	for (l = widget->var_list; l; l = l->next) {
+		xsg_var_t *var = l->data;
+
+		if (var != widget->visible_var) {
+			xsg_var_reset(var);
+		}
+	}
+
+	(widget->update_func)(widget, NULL);
+}
+
+void
+xsg_widgets_show_window(xsg_window_t *window)
+{
+	xsg_list_t *l;
+
+	for (l = widget_list; l; l = l->next) {
+		xsg_widget_t *widget = l->data;
+
+		if (widget->window == window && widget->visible) {
+			catch_up(widget);
+		}
+	}
+}
+
 void
 xsg_widgets_update_var(xsg_widget_t *widget, xsg_var_t *var)
 {
@@ -125,12 +188,34 @@ xsg_widgets_update_var(xsg_widget_t *widget, xsg_var_t *var)
 			xsg_window_update_append_rect(widget->window,
 					widget->xoffset, widget->yoffset,
 					widget->width, widget->height);
+
+			if (is_shown(widget)) {
+				catch_up(widget);
+			}
 		}
-	} else {
+	} else if (is_shown(widget)) {
 		(widget->update_func)(widget, var);
 	}
 }
 
+static bool
+vars_changed(xsg_widget_t *widget)
+{
+	xsg_list_t *l;
+	bool changed = FALSE;
+
+	/* ask every var, so that each one remembers what it has seen */
+	for (l = widget->var_list; l; l = l->next) {
+		xsg_var_t *var = l->data;
+
+		if (var != widget->visible_var && xsg_var_changed(var)) {
+			changed = TRUE;
+		}
+	}
+
+	return changed;
+}
+
 void
 xsg_widgets_update(uint64_t tick)
 {
@@ -138,8 +223,11 @@ xsg_widgets_update(uint64_t tick)
 
 	for (l = widget_list; l; l = l->next) {
 		xsg_widget_t *widget = l->data;
+		bool shown = FALSE;
 
-		if (widget->visible_var && tick % widget->visible_update == 0) {
+		if (widget->visible_var && tick % widget->visible_update == 0
+				&& xsg_window_is_visible(widget->window)
+				&& xsg_var_changed(widget->visible_var)) {
 			bool visible = widget->visible;
 
 			widget->visible = (xsg_var_get_num(widget->visible_var)
@@ -150,12 +238,29 @@ xsg_widgets_update(uint64_t tick)
 						widget->xoffset,
 						widget->yoffset,
 						widget->width, widget->height);
+				shown = widget->visible;
 			}
 		}
 
-		if (tick % widget->update == 0) {
+		if (tick % widget->update != 0) {
+			if (shown) {
+				catch_up(widget);
+			}
+			continue;
+		}
+
+		if (!is_shown(widget)) {
+			if (widget->skip_func != NULL) {
+				(widget->skip_func)(widget);
+			}
+		} else {
 			(widget->scroll_func)(widget);
-			(widget->update_func)(widget, NULL);
+			if (shown) {
+				catch_up(widget);
+			} else if (!widget->update_on_change
+					|| vars_changed(widget)) {
+				(widget->update_func)(widget, NULL);
+			}
 		}
 	}
 }
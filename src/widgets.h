@@ -34,6 +34,9 @@ xsg_widgets_update(uint64_t tick);
 extern void
 xsg_widgets_update_var(xsg_widget_t *widget, xsg_var_t *var);
 
+extern void
+xsg_widgets_show_window(xsg_window_t *window);
+
 extern xsg_widget_t *
 xsg_widgets_new(xsg_window_t *window);
 
@@ -31,6 +31,7 @@
 #include "window.h"
 #include "argb.h"
 #include "xrender.h"
+#include "shm.h"
 #include "update.h"
 #include "widgets.h"
 #include "imlib.h"
@@ -39,6 +40,15 @@
 
 /******************************************************************************/
 
+/* fixed cost of one update rect in pixels: a pass over the widgets into its
+ * own buffer and one upload request. Without shm every pixel is written to
+ * the X connection, so the pixels weigh more than the requests. Compare with
+ * "make bench-update". */
+#define UPDATE_RECT_COST_SHM 1024
+#define UPDATE_RECT_COST_XPUTIMAGE 256
+
+/******************************************************************************/
+
 struct _xsg_window_t {
 	char *config;
 	char *name;
@@ -83,8 +93,11 @@ struct _xsg_window_t {
 	Pixmap pixmap;
 	Pixmap mask;
 
+	xsg_shm_t *shm;
+	xsg_xrender_t *xrender;
+
 	Imlib_Updates xexpose_updates;
-	xsg_list_t *updates;
+	xsg_update_t *updates;
 
 	bool visible;
 	uint64_t visible_update;
@@ -93,12 +106,22 @@ struct _xsg_window_t {
 	unsigned int button_exit;
 	unsigned int button_move;
 
+	/* async renders: immediately (0), at most frame_rate frames per
+	 * second or only at tick boundaries */
+	unsigned frame_rate;
+	bool frame_tick;
+	struct timeval last_frame;
+	bool frame_pending;
+	xsg_main_timeout_t frame_timeout;
+
 	xsg_list_t *widget_list;
+	xsg_list_t *widget_list_last;
 };
 
 /******************************************************************************/
 
 static xsg_list_t *window_list = NULL;
+static xsg_list_t *window_list_last = NULL;
 
 static Display *display = NULL;
 static int screen = 0;
@@ -113,6 +136,9 @@ static xsg_main_poll_t poll = { 0 };
 static void
 copy_from_parent_timeout(void *arg, bool time_error);
 
+static void
+frame_timeout(void *arg, bool time_error);
+
 xsg_window_t *
 xsg_window_new(char *config_name, int flags, int xoffset, int yoffset)
 {
@@ -171,6 +197,9 @@ xsg_window_new(char *config_name, int flags, int xoffset, int yoffset)
 	window->pixmap = 0;
 	window->mask = 0;
 
+	window->shm = NULL;
+	window->xrender = NULL;
+
 	window->xexpose_updates = 0;
 	window->updates = NULL;
 
@@ -181,9 +210,21 @@ xsg_window_new(char *config_name, int flags, int xoffset, int yoffset)
 	window->button_exit = 0;
 	window->button_move = 0;
 
+	window->frame_rate = 0;
+	window->frame_tick = FALSE;
+	window->last_frame.tv_sec = 0;
+	window->last_frame.tv_usec = 0;
+	window->frame_pending = FALSE;
+	window->frame_timeout.tv.tv_sec = 0;
+	window->frame_timeout.tv.tv_usec = 0;
+	window->frame_timeout.func = frame_timeout;
+	window->frame_timeout.arg = window;
+
 	window->widget_list = NULL;
+	window->widget_list_last = NULL;
 
-	window_list = xsg_list_append(window_list, window);
+	window_list = xsg_list_append_last(window_list, &window_list_last,
+			window);
 
 	return window;
 }
@@ -193,7 +234,8 @@ xsg_window_new(char *config_name, int flags, int xoffset, int yoffset)
 void
 xsg_window_add_widget(xsg_window_t *window, xsg_widget_t *widget)
 {
-	window->widget_list = xsg_list_append(window->widget_list, widget);
+	window->widget_list = xsg_list_append_last(window->widget_list,
+			&window->widget_list_last, widget);
 }
 
 char *
@@ -202,6 +244,12 @@ xsg_window_get_config_name(xsg_window_t *window)
 	return window->config;
 }
 
+bool
+xsg_window_is_visible(xsg_window_t *window)
+{
+	return window->visible;
+}
+
 /******************************************************************************
  *
  * parse configuration
@@ -350,6 +398,19 @@ xsg_window_parse_argb_visual(xsg_window_t *window)
 	xsg_conf_read_newline();
 }
 
+void
+xsg_window_parse_frame_rate(xsg_window_t *window)
+{
+	if (xsg_conf_find_command("Tick")) {
+		window->frame_tick = TRUE;
+		window->frame_rate = 0;
+	} else {
+		window->frame_tick = FALSE;
+		window->frame_rate = xsg_conf_read_uint();
+	}
+	xsg_conf_read_newline();
+}
+
 void
 xsg_window_parse_visible(xsg_window_t *window)
 {
@@ -580,7 +641,7 @@ static void
 render(xsg_window_t *window)
 {
 	Imlib_Image buffer;
-	xsg_list_t *update;
+	xsg_list_t *updates, *update;
 
 	if (!window->visible) {
 		return;
@@ -615,8 +676,8 @@ render(xsg_window_t *window)
 
 				imlib_updates_get_coordinates(xexpose_update,
 						&x, &y, &w, &h);
-				window->updates = xsg_update_append_rect(
-						window->updates, x, y, w, h);
+				xsg_update_append_rect(window->updates,
+						x, y, w, h);
 			}
 
 			imlib_updates_free(window->xexpose_updates);
@@ -624,11 +685,19 @@ render(xsg_window_t *window)
 		}
 	}
 
-	if (window->updates == NULL) {
+	if (xsg_update_is_empty(window->updates)) {
 		return;
 	}
 
-	for (update = window->updates; update; update = update->next) {
+	updates = xsg_update_get_rects(window->updates);
+
+	xsg_gettimeofday(&window->last_frame, NULL);
+
+	if (window->shm != NULL) {
+		xsg_shm_begin(window->shm);
+	}
+
+	for (update = updates; update; update = update->next) {
 		int up_x = 0, up_y = 0, up_w = 0, up_h = 0;
 		xsg_list_t *l;
 
@@ -662,10 +731,15 @@ render(xsg_window_t *window)
 		imlib_context_set_blend(0);
 
 		if (window->argb_visual) {
-			xsg_xrender_render(window->window, window->visual,
-					window->mask, window->xshape,
+			xsg_xrender_render(window->xrender,
 					imlib_image_get_data_for_reading_only(),
 					up_x, up_y, up_w, up_h);
+		} else if (window->shm != NULL) {
+			xsg_shm_copy(window->shm,
+					imlib_image_get_data_for_reading_only(),
+					up_x, up_y, up_w, up_h);
+			xsg_shm_put(window->shm, window->window, up_x, up_y,
+					up_w, up_h);
 		} else {
 			imlib_render_image_on_drawable(up_x, up_y);
 		}
@@ -675,8 +749,7 @@ render(xsg_window_t *window)
 		imlib_free_image();
 	}
 
-	xsg_update_free(window->updates);
-	window->updates = NULL;
+	xsg_update_free(updates);
 
 	if (window->xshape > 0) {
 		if (window->argb_visual) {
@@ -693,6 +766,11 @@ render(xsg_window_t *window)
 			/* XSync(display, False); */
 		}
 	}
+
+	/* no round trip: the requests are processed in order, each rect has
+	 * its own area in the shm segment, which is only waited for before
+	 * the next frame writes it again */
+	XFlush(display);
 }
 
 /******************************************************************************
@@ -778,6 +856,11 @@ handle_xevent(void)
 	XEvent event;
 
 	XNextEvent(display, &event);
+
+	if (xsg_shm_handle_event(&event)) {
+		return;
+	}
+
 	for (l = window_list; l; l = l->next) {
 		xsg_window_t *window = l->data;
 
@@ -893,6 +976,57 @@ handle_xevents(void *arg, xsg_main_poll_events_t events)
  *
  ******************************************************************************/
 
+/* Renders outside of tick boundaries (e.g. triggered by a daemon or inotail
+ * var) are coalesced: with a frame rate, the update rects are collected until
+ * the next frame is due. */
+static void
+request_render(xsg_window_t *window)
+{
+	struct timeval now, next;
+
+	if (window->frame_tick) {
+		return;
+	}
+
+	if (window->frame_rate == 0) {
+		render(window);
+		return;
+	}
+
+	if (window->frame_pending || xsg_update_is_empty(window->updates)) {
+		return;
+	}
+
+	next.tv_sec = 0;
+	next.tv_usec = 1000000 / window->frame_rate;
+
+	xsg_timeradd(&window->last_frame, &next, &next);
+
+	xsg_gettimeofday(&now, NULL);
+
+	if (!xsg_timercmp(&now, &next, <)) {
+		render(window);
+		return;
+	}
+
+	window->frame_timeout.tv = next;
+	window->frame_pending = TRUE;
+
+	xsg_main_add_timeout(&window->frame_timeout);
+}
+
+static void
+frame_timeout(void *arg, bool time_error)
+{
+	xsg_window_t *window = (xsg_window_t *) arg;
+
+	window->frame_pending = FALSE;
+
+	render(window);
+
+	handle_xevents(NULL, 0);
+}
+
 void
 xsg_window_render(void)
 {
@@ -901,7 +1035,25 @@ xsg_window_render(void)
 	for (l = window_list; l; l = l->next) {
 		xsg_window_t *window = l->data;
 
-		render(window);
+		request_render(window);
+	}
+
+	handle_xevents(NULL, 0);
+}
+
+static void
+render_tick(void)
+{
+	xsg_list_t *l;
+
+	for (l = window_list; l; l = l->next) {
+		xsg_window_t *window = l->data;
+
+		if (window->frame_tick) {
+			render(window);
+		} else {
+			request_render(window);
+		}
 	}
 
 	handle_xevents(NULL, 0);
@@ -913,7 +1065,8 @@ xsg_window_render(void)
  *
  ******************************************************************************/
 
-static void
+/* returns TRUE if the window was mapped */
+static bool
 update_visible(xsg_window_t *window)
 {
 	bool visible;
@@ -958,12 +1111,16 @@ update_visible(xsg_window_t *window)
 
 			xsg_window_update_append_rect(window, 0, 0,
 					window->width, window->height);
+
+			return TRUE;
 		} else {
 			xsg_debug("%s: XUnmapWindow", window->config);
 
 			XUnmapWindow(display, window->window);
 		}
 	}
+
+	return FALSE;
 }
 
 /******************************************************************************
@@ -996,12 +1153,14 @@ xsg_window_update(uint64_t tick)
 		}
 
 		if ((window->visible_update != 0)
-		 && (tick % window->visible_update) == 0) {
-			update_visible(window);
+		 && (tick % window->visible_update) == 0
+		 && xsg_var_changed(window->visible_var)
+		 && update_visible(window)) {
+			xsg_widgets_show_window(window);
 		}
 	}
 
-	xsg_window_render();
+	render_tick();
 }
 
 
@@ -1020,8 +1179,13 @@ xsg_window_update_append_rect(
 	int height
 )
 {
-	window->updates = xsg_update_append_rect(window->updates, xoffset,
-			yoffset, width, height);
+	/* before xsg_window_init, which damages the whole window anyway */
+	if (window->updates == NULL) {
+		return;
+	}
+
+	xsg_update_append_rect(window->updates, xoffset, yoffset,
+			width, height);
 }
 
 /******************************************************************************
@@ -1038,7 +1202,9 @@ xsg_window_update_var(
 )
 {
 	if (widget == NULL) {
-		update_visible(window);
+		if (update_visible(window)) {
+			xsg_widgets_show_window(window);
+		}
 		xsg_window_render();
 	} else {
 		xsg_widgets_update_var(widget, var);
@@ -1241,6 +1407,8 @@ xsg_window_init(void)
 	imlib_context_set_anti_alias(1);
 	imlib_context_set_display(display);
 
+	xsg_shm_init(display);
+
 	for (l = window_list; l; l = l->next) {
 		xsg_window_t *window = l->data;
 		XSetWindowAttributes attrs;
@@ -1326,7 +1494,26 @@ xsg_window_init(void)
 			}
 		}
 
-		window->updates = xsg_update_append_rect(window->updates, 0, 0,
+		/* the non-argb xshape windows are rendered by imlib2, which
+		 * also creates the mask */
+		if (window->argb_visual || window->xshape == 0) {
+			window->shm = xsg_shm_new(window->visual,
+					window->depth, window->width,
+					window->height);
+		}
+
+		if (window->argb_visual) {
+			window->xrender = xsg_xrender_new(window->window,
+					window->visual, window->shm,
+					window->mask, window->xshape,
+					window->width, window->height);
+		}
+
+		window->updates = xsg_update_new(window->width,
+				window->height, window->shm != NULL
+				? UPDATE_RECT_COST_SHM
+				: UPDATE_RECT_COST_XPUTIMAGE);
+		xsg_update_append_rect(window->updates, 0, 0,
 				window->width, window->height);
 	}
 
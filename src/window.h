@@ -103,6 +103,9 @@ xsg_window_parse_xshape(xsg_window_t *window);
 extern void
 xsg_window_parse_argb_visual(xsg_window_t *window);
 
+extern void
+xsg_window_parse_frame_rate(xsg_window_t *window);
+
 extern void
 xsg_window_parse_visible(xsg_window_t *window);
 
@@ -131,6 +134,9 @@ xsg_window_add_widget(xsg_window_t *window, xsg_widget_t *widget);
 extern char *
 xsg_window_get_config_name(xsg_window_t *window);
 
+extern bool
+xsg_window_is_visible(xsg_window_t *window);
+
 /******************************************************************************/
 
 #endif /* __WINDOW_H__ */
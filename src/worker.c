@@ -0,0 +1,259 @@
+/* worker.c
+ *
+ * This file is part of xsysguard <http://xsysguard.sf.net>
+ * Copyright (C) 2005-2008 Sascha Wessel <sawe@users.sf.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Blocking samplers (slow sysfs or NFS files, ioctls, ...) are run by a pool
+ * of worker threads, so they cannot stall the main loop. The results are
+ * published by the main thread at the next tick boundary. A job that is still
+ * queued or running when it is submitted again is skipped.
+ */
+
+#include <xsysguard.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+
+#include "worker.h"
+
+/******************************************************************************/
+
+#define JOB_IDLE	0
+#define JOB_QUEUED	1
+#define JOB_RUNNING	2
+#define JOB_DONE	3
+
+/******************************************************************************/
+
+/* the pool's state of a job, entries are only created and looked up by the
+ * main thread, the worker threads just follow the links */
+typedef struct _entry_t {
+	xsg_worker_job_t *job;
+	int state;
+	struct _entry_t *next;
+} entry_t;
+
+/******************************************************************************/
+
+static unsigned thread_count = 0;
+static pthread_t *threads = NULL;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+static xsg_hash_table_t *entry_table = NULL;	/* job -> entry_t */
+
+static entry_t *queue_head = NULL;
+static entry_t *queue_tail = NULL;
+static entry_t *done_list = NULL;
+
+static bool quit = FALSE;
+
+/******************************************************************************/
+
+static void *
+worker_thread(void *arg)
+{
+	entry_t *entry;
+
+	pthread_mutex_lock(&mutex);
+
+	while (1) {
+		while (queue_head == NULL && !quit) {
+			pthread_cond_wait(&cond, &mutex);
+		}
+
+		if (quit) {
+			break;
+		}
+
+		entry = queue_head;
+		queue_head = entry->next;
+
+		if (queue_head == NULL) {
+			queue_tail = NULL;
+		}
+
+		entry->state = JOB_RUNNING;
+		entry->next = NULL;
+
+		pthread_mutex_unlock(&mutex);
+
+		entry->job->sample(entry->job->arg);
+
+		pthread_mutex_lock(&mutex);
+
+		entry->state = JOB_DONE;
+		entry->next = done_list;
+		done_list = entry;
+	}
+
+	pthread_mutex_unlock(&mutex);
+
+	return NULL;
+}
+
+/******************************************************************************/
+
+void
+xsg_worker_submit(xsg_worker_job_t *job)
+{
+	entry_t *entry;
+
+	if (thread_count == 0) {
+		job->sample(job->arg);
+		job->publish(job->arg);
+		return;
+	}
+
+	entry = xsg_hash_table_lookup(entry_table, job);
+
+	if (entry == NULL) {
+		entry = xsg_new(entry_t, 1);
+		entry->job = job;
+		entry->state = JOB_IDLE;
+		entry->next = NULL;
+		xsg_hash_table_insert(entry_table, job, entry);
+	}
+
+	pthread_mutex_lock(&mutex);
+
+	if (entry->state != JOB_IDLE) {
+		pthread_mutex_unlock(&mutex);
+		xsg_debug("worker job %p still busy: skipping", job);
+		return;
+	}
+
+	entry->state = JOB_QUEUED;
+	entry->next = NULL;
+
+	if (queue_tail == NULL) {
+		queue_head = entry;
+	} else {
+		queue_tail->next = entry;
+	}
+
+	queue_tail = entry;
+
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+bool
+xsg_worker_enabled(void)
+{
+	return thread_count != 0;
+}
+
+/******************************************************************************/
+
+void
+xsg_worker_publish(void)
+{
+	entry_t *list, *entry, *prev = NULL;
+
+	if (thread_count == 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&mutex);
+
+	list = done_list;
+	done_list = NULL;
+
+	for (entry = list; entry; entry = entry->next) {
+		entry->state = JOB_IDLE;
+	}
+
+	pthread_mutex_unlock(&mutex);
+
+	/* done_list is in reverse order of completion */
+	while (list) {
+		entry = list->next;
+		list->next = prev;
+		prev = list;
+		list = entry;
+	}
+
+	while (prev) {
+		entry = prev;
+		prev = prev->next;
+		entry->next = NULL;
+		entry->job->publish(entry->job->arg);
+	}
+}
+
+/******************************************************************************/
+
+/* NOTE: worker threads blocked in a sampler are not joined, they are
+ * terminated on exit */
+static void
+shutdown_workers(void)
+{
+	pthread_mutex_lock(&mutex);
+	quit = TRUE;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void
+xsg_worker_init(unsigned num)
+{
+	sigset_t all, old;
+	unsigned i;
+
+	if (num == 0 || thread_count != 0) {
+		return;
+	}
+
+	xsg_message("starting %u worker threads", num);
+
+	threads = xsg_new(pthread_t, num);
+
+	entry_table = xsg_hash_table_new(xsg_direct_hash, xsg_direct_equal);
+
+	/* NOTE: the threads inherit the signal mask, block everything so
+	 * process directed signals are always handled by the main thread,
+	 * where they are read from the signalfd */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+
+	for (i = 0; i < num; i++) {
+		int e;
+
+		e = pthread_create(&threads[i], NULL, worker_thread, NULL);
+
+		if (e != 0) {
+			xsg_warning("cannot create worker thread: %s",
+					strerror(e));
+			break;
+		}
+
+		pthread_detach(threads[i]);
+	}
+
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	thread_count = i;
+
+	if (thread_count != 0) {
+		xsg_main_add_shutdown_func(shutdown_workers);
+	}
+}
+
@@ -26,7 +26,7 @@
 #include <string.h>
 
 #include "xrender.h"
-/* #include "argb.h" */
+#include "argb.h"
 
 /******************************************************************************/
 
@@ -305,6 +305,78 @@ xsg_xrender_redirect(Window window)
 
 /******************************************************************************/
 
+/* the pixmaps and pictures are sized to the window and reused for every
+ * update, only the dirty rectangle is uploaded and composited */
+struct _xsg_xrender_t {
+	Window window;
+	Visual *visual;
+	xsg_shm_t *shm;
+	Pixmap mask;
+	unsigned xshape;
+
+	GC gc;
+	GC mask_gc;
+
+	Pixmap pixmap;
+
+	Picture picture;
+	Picture root_picture;
+};
+
+/******************************************************************************/
+
+xsg_xrender_t *
+xsg_xrender_new(
+	Window window,
+	Visual *visual,
+	xsg_shm_t *shm,
+	Pixmap mask,
+	unsigned xshape,
+	unsigned width,
+	unsigned height
+)
+{
+	xsg_xrender_t *xrender;
+	XRenderPictFormat *picture_format;
+	XRenderPictureAttributes root_picture_attrs;
+	XGCValues gcv;
+
+	xrender = xsg_new0(xsg_xrender_t, 1);
+
+	xrender->window = window;
+	xrender->visual = visual;
+	xrender->shm = shm;
+	xrender->mask = mask;
+	xrender->xshape = xshape;
+
+	gcv.graphics_exposures = False;
+
+	xrender->pixmap = XCreatePixmap(display, window, width, height, 32);
+
+	xrender->gc = XCreateGC(display, xrender->pixmap, GCGraphicsExposures,
+			&gcv);
+
+	if (xshape) {
+		xrender->mask_gc = XCreateGC(display, mask,
+				GCGraphicsExposures, &gcv);
+	}
+
+	picture_format = XRenderFindStandardFormat(display, 0);
+
+	root_picture_attrs.subwindow_mode = IncludeInferiors;
+
+	xrender->root_picture = XRenderCreatePicture(display, window,
+			XRenderFindVisualFormat(display, visual),
+			(1 << 8), &root_picture_attrs);
+
+	xrender->picture = XRenderCreatePicture(display, xrender->pixmap,
+			picture_format, 0, 0);
+
+	return xrender;
+}
+
+/******************************************************************************/
+
 static XImage *
 create_ximage(Visual *visual, unsigned depth, unsigned width, unsigned height)
 {
@@ -323,14 +395,33 @@ create_ximage(Visual *visual, unsigned depth, unsigned width, unsigned height)
 	return ximage;
 }
 
+static void
+put_image(
+	xsg_xrender_t *xrender,
+	uint32_t *data,
+	int xoffset,
+	int yoffset,
+	unsigned width,
+	unsigned height
+)
+{
+	XImage *ximage;
+
+	ximage = create_ximage(xrender->visual, 32, width, height);
+
+	xsg_argb_premultiply((uint32_t *) ximage->data, data, width * height);
+
+	XPutImage(display, xrender->pixmap, xrender->gc, ximage, 0, 0,
+			xoffset, yoffset, width, height);
+
+	XDestroyImage(ximage);
+}
+
 /******************************************************************************/
 
 void
 xsg_xrender_render(
-	Window window,
-	Visual *visual,
-	Pixmap mask,
-	unsigned xshape,
+	xsg_xrender_t *xrender,
 	uint32_t *data,
 	int xoffset,
 	int yoffset,
@@ -338,123 +429,55 @@ xsg_xrender_render(
 	unsigned height
 )
 {
-	XImage *ximage, *alpha_ximage;
-	Pixmap pixmap, alpha_pixmap;
-	Picture picture, alpha_picture, root_picture;
-	XRenderPictFormat *picture_format;
-	XRenderPictureAttributes root_picture_attrs;
-	unsigned i;
-	XGCValues gcv;
-	GC gc;
-
-	gcv.graphics_exposures = False;
-
 	xsg_debug("XRender xoffset=%d, yoffset=%d, width=%d, height=%d",
 			xoffset, yoffset, width, height);
 
-	if (xshape) {
+	if (xrender->xshape) {
 		XImage *mask_ximage;
-		unsigned x, y;
-		uint32_t *d;
-		GC mask_gc;
+		bool msb_first = am_big_endian();
+		unsigned y;
 
 		xsg_debug("Render xshape mask");
 
-		mask_ximage = create_ximage(visual, 1, width, height);
-
-		memset(mask_ximage->data, 0,
-			mask_ximage->bytes_per_line * mask_ximage->height);
-
-		d = data;
+		mask_ximage = create_ximage(xrender->visual, 1, width, height);
 
 		for (y = 0; y < height; y++) {
-			uint8_t *m = (uint8_t *) mask_ximage->data + y
-				* mask_ximage->bytes_per_line;
-
-			for (x = 0; x < width; x++) {
-				if ((*d >> 24) >= xshape) {
-					if (am_big_endian()) {
-						*m |= (1 << (0x7 - (x & 0x7)));
-					} else {
-						*m |= (1 << (x & 0x7));
-					}
-				}
-				if ((x & 0x7) == 0x7) {
-					m++;
-				}
-				d++;
-			}
+			xsg_argb_mask_bits((uint8_t *) mask_ximage->data
+					+ y * mask_ximage->bytes_per_line,
+					data + y * width, width,
+					xrender->xshape, msb_first);
 		}
 
-		mask_gc = XCreateGC(display, mask, GCGraphicsExposures, &gcv);
-
-		XPutImage(display, mask, mask_gc, mask_ximage, 0, 0,
-				xoffset, yoffset, width, height);
-
-		XFreeGC(display, mask_gc);
+		XPutImage(display, xrender->mask, xrender->mask_gc,
+				mask_ximage, 0, 0, xoffset, yoffset,
+				width, height);
 
 		XDestroyImage(mask_ximage);
 	}
 
-	ximage = create_ximage(visual, 32, width, height);
-	alpha_ximage = create_ximage(visual, 32, width, height);
-
-	for (i = 0; i < (width * height); i++) {
-#if 0
-		A_VAL((uint32_t *) ximage->data + i) = 0xff;
-		R_VAL((uint32_t *) ximage->data + i) = R_VAL(data + i);
-		G_VAL((uint32_t *) ximage->data + i) = G_VAL(data + i);
-		B_VAL((uint32_t *) ximage->data + i) = B_VAL(data + i);
-#endif
-		((uint32_t *)ximage->data)[i] = data[i];
-#if 0
-		A_VAL((uint32_t *) alpha_ximage->data + i) = A_VAL(data + i);
-		R_VAL((uint32_t *) alpha_ximage->data + i) = 0x00;
-		G_VAL((uint32_t *) alpha_ximage->data + i) = 0x00;
-		B_VAL((uint32_t *) alpha_ximage->data + i) = 0x00;
-#endif
-		((uint32_t *)alpha_ximage->data)[i] = data[i];
-	}
-
-	pixmap = XCreatePixmap(display, window, width, height, 32);
-	alpha_pixmap = XCreatePixmap(display, window, width, height, 32);
-
-	gc = XCreateGC(display, window, GCGraphicsExposures, &gcv);
-
-	XPutImage(display, pixmap, gc, ximage, 0, 0, 0, 0, width, height);
-	XPutImage(display, alpha_pixmap, gc, alpha_ximage, 0, 0, 0, 0,
-			width, height);
-
-	XFreeGC(display, gc);
-
-	XDestroyImage(ximage);
-	XDestroyImage(alpha_ximage);
-
-	picture_format = XRenderFindStandardFormat(display, 0);
-
-	root_picture_attrs.subwindow_mode = IncludeInferiors;
-
-	root_picture = XRenderCreatePicture(display, window,
-			XRenderFindVisualFormat(display, visual),
-			(1 << 8), &root_picture_attrs);
-
-	picture = XRenderCreatePicture(display, pixmap, picture_format, 0, 0);
-	alpha_picture = XRenderCreatePicture(display, alpha_pixmap,
-			picture_format, 0, 0);
+	if (xrender->shm != NULL) {
+		uint32_t *d;
+		unsigned stride, y;
 
-	XRenderComposite(display, 1, picture, alpha_picture,
-			root_picture, 0, 0, 0, 0,
-			xoffset, yoffset, width, height);
+		d = xsg_shm_get_data(xrender->shm, &stride);
+		d += yoffset * stride + xoffset;
 
-	XRenderFreePicture(display, picture);
-	XRenderFreePicture(display, alpha_picture);
+		for (y = 0; y < height; y++) {
+			xsg_argb_premultiply(d + y * stride, data + y * width,
+					width);
+		}
 
-	XFreePixmap(display, pixmap);
-	XFreePixmap(display, alpha_pixmap);
+		xsg_shm_put(xrender->shm, xrender->pixmap, xoffset, yoffset,
+				width, height);
+	} else {
+		put_image(xrender, data, xoffset, yoffset, width, height);
+	}
 
-	XSync(display, False);
+	/* PictOpSrc: the buffer holds the whole window content including
+	 * its background, so it replaces the window content */
+	XRenderComposite(display, 1, xrender->picture, 0,
+			xrender->root_picture, xoffset, yoffset,
+			0, 0, xoffset, yoffset, width, height);
 
 	xsg_debug("XRender finished");
 }
-
-
@@ -24,6 +24,12 @@
 #include <xsysguard.h>
 #include <X11/Xlib.h>
 
+#include "shm.h"
+
+/******************************************************************************/
+
+typedef struct _xsg_xrender_t xsg_xrender_t;
+
 /******************************************************************************/
 
 extern void
@@ -35,12 +41,20 @@ xsg_xrender_find_visual(int screen);
 extern void
 xsg_xrender_redirect(Window window);
 
-extern void
-xsg_xrender_render(
+extern xsg_xrender_t *
+xsg_xrender_new(
 	Window window,
 	Visual *visual,
+	xsg_shm_t *shm,
 	Pixmap mask,
 	unsigned xshape,
+	unsigned width,
+	unsigned height
+);
+
+extern void
+xsg_xrender_render(
+	xsg_xrender_t *xrender,
 	uint32_t *data,
 	int xoffset,
 	int yoffset,
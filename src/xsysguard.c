@@ -26,6 +26,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <limits.h>
 #include <getopt.h>
 #include <stdarg.h>
 #include <time.h>
@@ -35,9 +36,12 @@
 #include "conf.h"
 #include "main.h"
 #include "var.h"
+#include "worker.h"
+#include "profile.h"
 #include "imlib.h"
 #include "printf.h"
 #include "window.h"
+#include "shm.h"
 #include "widgets.h"
 #include "widget_line.h"
 #include "widget_rectangle.h"
@@ -206,6 +210,146 @@ parse_env(const char *config_name)
 	xsg_free(value);
 }
 
+enum {
+	SET_NAME,
+	SET_CLASS,
+	SET_RESOURCE,
+	SET_SIZE,
+	SET_POSITION,
+	SET_STICKY,
+	SET_SKIP_TASKBAR,
+	SET_SKIP_PAGER,
+	SET_LAYER,
+	SET_DECORATIONS,
+	SET_OVERRIDE_REDIRECT,
+	SET_BACKGROUND,
+	SET_XSHAPE,
+	SET_ARGB_VISUAL,
+	SET_FRAME_RATE,
+	SET_VISIBLE,
+	SET_MOUSE
+};
+
+static const char * const set_keyword_names[] = {
+	"Name",
+	"Class",
+	"Resource",
+	"Size",
+	"Position",
+	"Sticky",
+	"SkipTaskbar",
+	"SkipPager",
+	"Layer",
+	"Decorations",
+	"OverrideRedirect",
+	"Background",
+	"XShape",
+	"ARGBVisual",
+	"FrameRate",
+	"Visible",
+	"Mouse"
+};
+
+static xsg_conf_keywords_t set_keywords =
+	XSG_CONF_KEYWORDS(set_keyword_names);
+
+static void
+parse_set(xsg_window_t *window)
+{
+	switch (xsg_conf_find_keyword(&set_keywords)) {
+	case SET_NAME:
+		xsg_window_parse_name(window);
+		break;
+	case SET_CLASS:
+		xsg_window_parse_class(window);
+		break;
+	case SET_RESOURCE:
+		xsg_window_parse_resource(window);
+		break;
+	case SET_SIZE:
+		xsg_window_parse_size(window);
+		break;
+	case SET_POSITION:
+		xsg_window_parse_position(window);
+		break;
+	case SET_STICKY:
+		xsg_window_parse_sticky(window);
+		break;
+	case SET_SKIP_TASKBAR:
+		xsg_window_parse_skip_taskbar(window);
+		break;
+	case SET_SKIP_PAGER:
+		xsg_window_parse_skip_pager(window);
+		break;
+	case SET_LAYER:
+		xsg_window_parse_layer(window);
+		break;
+	case SET_DECORATIONS:
+		xsg_window_parse_decorations(window);
+		break;
+	case SET_OVERRIDE_REDIRECT:
+		xsg_window_parse_override_redirect(window);
+		break;
+	case SET_BACKGROUND:
+		xsg_window_parse_background(window);
+		break;
+	case SET_XSHAPE:
+		xsg_window_parse_xshape(window);
+		break;
+	case SET_ARGB_VISUAL:
+		xsg_window_parse_argb_visual(window);
+		break;
+	case SET_FRAME_RATE:
+		xsg_window_parse_frame_rate(window);
+		break;
+	case SET_VISIBLE:
+		xsg_window_parse_visible(window);
+		break;
+	case SET_MOUSE:
+		xsg_window_parse_mouse(window);
+		break;
+	default:
+		xsg_conf_error("Name, Class, Resource, Size, Position, Sticky, "
+				"SkipTaskbar, SkipPager, Layer, Decorations, "
+				"OverrideRedirect, Background, XShape, "
+				"ARGBVisual, FrameRate, Visible or Mouse "
+				"expected");
+	}
+}
+
+enum {
+	CONFIG_SET,
+	CONFIG_MODULE_ENV,
+	CONFIG_SET_ENV,
+	CONFIG_LINE,
+	CONFIG_RECTANGLE,
+	CONFIG_ELLIPSE,
+	CONFIG_POLYGON,
+	CONFIG_IMAGE,
+	CONFIG_BAR_CHART,
+	CONFIG_LINE_CHART,
+	CONFIG_AREA_CHART,
+	CONFIG_TEXT
+};
+
+static const char * const config_keyword_names[] = {
+	"Set",
+	"ModuleEnv",
+	"SetEnv",
+	"Line",
+	"Rectangle",
+	"Ellipse",
+	"Polygon",
+	"Image",
+	"BarChart",
+	"LineChart",
+	"AreaChart",
+	"Text"
+};
+
+static xsg_conf_keywords_t config_keywords =
+	XSG_CONF_KEYWORDS(config_keyword_names);
+
 static void
 parse_config(
 	char *config_name,
@@ -227,73 +371,47 @@ parse_config(
 		if (xsg_conf_find_commentline()) {
 			continue;
 		}
-		if (xsg_conf_find_command("Set")) {
-			if (xsg_conf_find_command("Name")) {
-				xsg_window_parse_name(window);
-			} else if (xsg_conf_find_command("Class")) {
-				xsg_window_parse_class(window);
-			} else if (xsg_conf_find_command("Resource")) {
-				xsg_window_parse_resource(window);
-			} else if (xsg_conf_find_command("Size")) {
-				xsg_window_parse_size(window);
-			} else if (xsg_conf_find_command("Position")) {
-				xsg_window_parse_position(window);
-			} else if (xsg_conf_find_command("Sticky")) {
-				xsg_window_parse_sticky(window);
-			} else if (xsg_conf_find_command("SkipTaskbar")) {
-				xsg_window_parse_skip_taskbar(window);
-			} else if (xsg_conf_find_command("SkipPager")) {
-				xsg_window_parse_skip_pager(window);
-			} else if (xsg_conf_find_command("Layer")) {
-				xsg_window_parse_layer(window);
-			} else if (xsg_conf_find_command("Decorations")) {
-				xsg_window_parse_decorations(window);
-			} else if (xsg_conf_find_command("OverrideRedirect")) {
-				xsg_window_parse_override_redirect(window);
-			} else if (xsg_conf_find_command("Background")) {
-				xsg_window_parse_background(window);
-			} else if (xsg_conf_find_command("XShape")) {
-				xsg_window_parse_xshape(window);
-			} else if (xsg_conf_find_command("ARGBVisual")) {
-				xsg_window_parse_argb_visual(window);
-			} else if (xsg_conf_find_command("Visible")) {
-				xsg_window_parse_visible(window);
-			} else if (xsg_conf_find_command("Mouse")) {
-				xsg_window_parse_mouse(window);
-			} else {
-				xsg_conf_error("Name, Class, Resource, "
-						"Size, Position, Sticky, "
-						"SkipTaskbar, SkipPager, "
-						"Layer, Decorations, "
-						"OverrideRedirect, Background, "
-						"XShape, ARGBVisual or "
-						"Visible expected");
-			}
-		} else if (xsg_conf_find_command("ModuleEnv")) {
+		switch (xsg_conf_find_keyword(&config_keywords)) {
+		case CONFIG_SET:
+			parse_set(window);
+			break;
+		case CONFIG_MODULE_ENV: {
 			char *module_name = xsg_conf_read_string();
 			xsg_modules_help(module_name);
 			xsg_free(module_name);
-		} else if (xsg_conf_find_command("SetEnv")) {
+			break;
+		}
+		case CONFIG_SET_ENV:
 			parse_env(config_name);
-		} else if (xsg_conf_find_command("Line")) {
+			break;
+		case CONFIG_LINE:
 			xsg_widget_line_parse(window);
-		} else if (xsg_conf_find_command("Rectangle")) {
+			break;
+		case CONFIG_RECTANGLE:
 			xsg_widget_rectangle_parse(window);
-		} else if (xsg_conf_find_command("Ellipse")) {
+			break;
+		case CONFIG_ELLIPSE:
 			xsg_widget_ellipse_parse(window);
-		} else if (xsg_conf_find_command("Polygon")) {
+			break;
+		case CONFIG_POLYGON:
 			xsg_widget_polygon_parse(window);
-		} else if (xsg_conf_find_command("Image")) {
+			break;
+		case CONFIG_IMAGE:
 			xsg_widget_image_parse(window);
-		} else if (xsg_conf_find_command("BarChart")) {
+			break;
+		case CONFIG_BAR_CHART:
 			xsg_widget_barchart_parse(window);
-		} else if (xsg_conf_find_command("LineChart")) {
+			break;
+		case CONFIG_LINE_CHART:
 			xsg_widget_linechart_parse(window);
-		} else if (xsg_conf_find_command("AreaChart")) {
+			break;
+		case CONFIG_AREA_CHART:
 			xsg_widget_areachart_parse(window);
-		} else if (xsg_conf_find_command("Text")) {
+			break;
+		case CONFIG_TEXT:
 			xsg_widget_text_parse(window);
-		} else {
+			break;
+		default:
 			xsg_conf_error("#, Set, SetEnv, ModuleEnv, Line, "
 					"Rectangle, Ellipse, Polygon, "
 					"Image, BarChart, LineChart, "
@@ -440,7 +558,11 @@ usage(bool enable_fontconfig)
 		"  -d, --fontdirs     Print a list of all font dirs to stdout (libfontconfig)\n"
 		"  -i, --interval=N   Set main interval to N milliseconds (default: %"PRIu64")\n"
 		"  -n, --num=N        Exit after N tick's\n"
+		"  -w, --workers=N    Run blocking samplers in N threads (default: 0)\n"
+		"  -o, --overrun=P    Coalesce or skip missed ticks: coalesce, skip (default: coalesce)\n"
+		"  -p, --profile      Profile callbacks, print statistics on SIGUSR1 and exit\n"
 		"  -N, --nofontconfig Disable libfontconfig\n"
+		"  -S, --noshm        Disable the MIT-SHM extension\n"
 		"  -F, --fontcache=N  Set Imlib2's font cache size to N bytes (default: %d)\n"
 		"  -I, --imgcache=N   Set Imlib2's image cache size to N bytes (default: %d)\n"
 		"  -c, --color        Enable colored logging\n"
@@ -576,6 +698,8 @@ main(int argc, char **argv)
 	int font_cache_size = DEFAULT_FONT_CACHE_SIZE;
 	int image_cache_size = DEFAULT_IMAGE_CACHE_SIZE;
 	bool enable_fontconfig = TRUE;
+	unsigned workers = 0;
+	uint64_t start;
 
 	struct option long_options[] = {
 		{ "help",         0, NULL, 'h' },
@@ -583,7 +707,11 @@ main(int argc, char **argv)
 		{ "license",      0, NULL, 'L' },
 		{ "interval",     1, NULL, 'i' },
 		{ "num",          1, NULL, 'n' },
+		{ "workers",      1, NULL, 'w' },
+		{ "overrun",      1, NULL, 'o' },
+		{ "profile",      0, NULL, 'p' },
 		{ "nofontconfig", 0, NULL, 'N' },
+		{ "noshm",        0, NULL, 'S' },
 		{ "fontcache",    1, NULL, 'F' },
 		{ "imgcache",     1, NULL, 'I' },
 		{ "log",          1, NULL, 'l' },
@@ -599,7 +727,7 @@ main(int argc, char **argv)
 	while (1) {
 		int option, option_index = 0;
 
-		option = getopt_long(argc, argv, "hH:Li:n:NF:I:l:mfdct",
+		option = getopt_long(argc, argv, "hH:Li:n:w:o:pNSF:I:l:mfdct",
 				long_options, &option_index);
 
 		if (option == EOF) {
@@ -622,9 +750,40 @@ main(int argc, char **argv)
 		case 'n':
 			sscanf(optarg, "%"SCNu64, &num);
 			break;
+		case 'w':
+			if (optarg) {
+				char *end;
+				long n;
+
+				errno = 0;
+				n = strtol(optarg, &end, 10);
+
+				if (end == optarg || *end != '\0' || errno != 0
+						|| n < 0 || n > INT_MAX) {
+					print_usage = TRUE;
+				} else {
+					workers = n;
+				}
+			}
+			break;
+		case 'o':
+			if (optarg && !strcmp(optarg, "skip")) {
+				xsg_main_set_skip_missed_ticks(TRUE);
+			} else if (optarg && !strcmp(optarg, "coalesce")) {
+				xsg_main_set_skip_missed_ticks(FALSE);
+			} else {
+				print_usage = TRUE;
+			}
+			break;
+		case 'p':
+			xsg_profile_enable();
+			break;
 		case 'N':
 			enable_fontconfig = FALSE;
 			break;
+		case 'S':
+			xsg_shm_disable();
+			break;
 		case 'F':
 			if (optarg) {
 				font_cache_size = atoi(optarg);
@@ -741,7 +900,10 @@ main(int argc, char **argv)
 
 		filename = find_config_file(config_name);
 		config_buffer = get_config_file(argv[optind], filename);
+
+		start = xsg_profile_start();
 		parse_config(argv[optind], config_buffer, flags, xoffset, yoffset);
+		xsg_profile_stop(xsg_profile_new("startup", config_name), start);
 
 		xsg_free(config_name);
 		xsg_free(config_buffer);
@@ -750,8 +912,11 @@ main(int argc, char **argv)
 		optind++;
 	}
 
+	start = xsg_profile_start();
 	xsg_window_init();
 	xsg_imlib_init();
+	xsg_worker_init(workers);
+	xsg_profile_stop(xsg_profile_new("startup", "window_init"), start);
 
 	xsg_main_loop(num);
 
@@ -24,12 +24,15 @@
 #include <string.h>
 #include <getopt.h>
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
 
 #include "modules.h"
 #include "conf.h"
 #include "main.h"
 #include "vard.h"
+#include "worker.h"
+#include "profile.h"
 #include "writebuffer.h"
 
 /******************************************************************************/
@@ -321,6 +324,9 @@ usage(void)
 		"  -s, --stderr        Print log messages to stderr\n"
 		"  -c, --color         Enable colored logging\n"
 		"  -t, --time          Add current time to each log line\n"
+		"  -w, --workers=N     Run blocking samplers in N threads (default: 0)\n"
+		"  -o, --overrun=P     Coalesce or skip missed ticks: coalesce, skip (default: coalesce)\n"
+		"  -p, --profile       Profile callbacks, print statistics on SIGUSR1 and exit\n"
 		"  -l, --log=N         Set loglevel to N: ");
 
 	if (XSG_LOG_LEVEL_ERROR <= XSG_LOG_LEVEL_MAX) {
@@ -383,6 +389,7 @@ main(int argc, char **argv)
 	bool print_license = FALSE;
 	bool log_level_overwrite = FALSE;
 	char *mhelp = NULL;
+	unsigned workers = 0;
 
 	struct option long_options[] = {
 		{ "help",    0, NULL, 'h' },
@@ -393,6 +400,9 @@ main(int argc, char **argv)
 		{ "time",    0, NULL, 't' },
 		{ "stderr",  0, NULL, 's' },
 		{ "modules", 0, NULL, 'm' },
+		{ "workers", 1, NULL, 'w' },
+		{ "overrun", 1, NULL, 'o' },
+		{ "profile", 0, NULL, 'p' },
 		{ NULL,      0, NULL,  0  }
 	};
 
@@ -408,7 +418,7 @@ main(int argc, char **argv)
 	while (1) {
 		int option, option_index = 0;
 
-		option = getopt_long(argc, argv, "hH:Ll:csmt", long_options,
+		option = getopt_long(argc, argv, "hH:Ll:csmtw:o:p", long_options,
 				&option_index);
 
 		if (option == EOF)
@@ -443,6 +453,36 @@ main(int argc, char **argv)
 			list_modules = TRUE;
 			log_to_stderr = TRUE;
 			break;
+		case 'p':
+			xsg_profile_enable();
+			break;
+		case 'w':
+			if (optarg) {
+				char *end;
+				long n;
+
+				errno = 0;
+				n = strtol(optarg, &end, 10);
+
+				if (end == optarg || *end != '\0' || errno != 0
+						|| n < 0 || n > INT_MAX) {
+					print_usage = TRUE;
+					log_to_stderr = TRUE;
+				} else {
+					workers = n;
+				}
+			}
+			break;
+		case 'o':
+			if (optarg && !strcmp(optarg, "skip")) {
+				xsg_main_set_skip_missed_ticks(TRUE);
+			} else if (optarg && !strcmp(optarg, "coalesce")) {
+				xsg_main_set_skip_missed_ticks(FALSE);
+			} else {
+				print_usage = TRUE;
+				log_to_stderr = TRUE;
+			}
+			break;
 		case '?':
 			print_usage = TRUE;
 			log_to_stderr = TRUE;
@@ -493,6 +533,8 @@ main(int argc, char **argv)
 
 	xsg_vard_init(read_config(stdin, log_level_overwrite));
 
+	xsg_worker_init(workers);
+
 	xsg_main_loop(0);
 
 	return EXIT_SUCCESS;